@@ -1,5 +1,9 @@
 zip -r project1-submission.zip \
        src/include/buffer/lru_replacer.h  \
        src/buffer/lru_replacer.cpp \
-       src/include/buffer/buffer_pool_manager.h  \
-       src/buffer/buffer_pool_manager.cpp
\ No newline at end of file
+       src/include/buffer/lru_k_replacer.h  \
+       src/buffer/lru_k_replacer.cpp \
+       src/include/buffer/buffer_pool_manager_instance.h  \
+       src/buffer/buffer_pool_manager_instance.cpp \
+       src/include/buffer/parallel_buffer_pool_manager.h  \
+       src/buffer/parallel_buffer_pool_manager.cpp
\ No newline at end of file
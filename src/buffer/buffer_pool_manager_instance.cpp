@@ -0,0 +1,990 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_instance.cpp
+//
+// Identification: src/buffer/buffer_pool_manager_instance.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <list>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     size_t max_pool_size, size_t compressed_cache_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_policy, max_pool_size,
+                                compressed_cache_size) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      arena_(max_pool_size_),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      page_cache_(compressed_cache_size > 0 ? std::make_unique<CompressedPageCache>(compressed_cache_size) : nullptr) {
+  BUSTUB_ASSERT(num_instances > 0, "A standalone instance is a pool of exactly one instance.");
+  BUSTUB_ASSERT(instance_index < num_instances, "Instance index must be smaller than the number of instances.");
+  // We allocate a consecutive memory space for the buffer pool. The frames come from the arena, the pages that
+  // describe them are kept apart so that scanning their metadata does not drag page data through the cache. Both are
+  // sized for the largest pool, so that growing never moves a page somebody holds.
+  pages_ = static_cast<Page *>(::operator new[](max_pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (pages_ + i) Page(arena_.GetFrame(static_cast<frame_id_t>(i)));
+  }
+  frame_states_ = new FrameState[max_pool_size_];
+  frame_cvs_ = new std::condition_variable[max_pool_size_];
+  rec_lsns_ = new lsn_t[max_pool_size_];
+  switch (replacer_policy) {
+    case ReplacerPolicy::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerPolicy::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerPolicy::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
+
+  // Initially, every page is in the free list.
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    frame_states_[i] = FrameState::FREE;
+    rec_lsns_[i] = INVALID_LSN;
+  }
+  for (size_t i = 0; i < pool_size_; ++i) {
+    free_list_.emplace_back(static_cast<int>(i));
+  }
+  frames_registered_ = disk_manager_->RegisterBuffers(arena_.GetFrame(0), pool_size_ * PAGE_SIZE);
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopBackgroundWriter();
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    stop_prefetching_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
+  if (frames_registered_) {
+    disk_manager_->UnregisterBuffers(arena_.GetFrame(0));
+  }
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t{alignof(Page)});
+  delete[] frame_states_;
+  delete[] frame_cvs_;
+  delete[] rec_lsns_;
+  delete replacer_;
+}
+
+Page *BufferPoolManagerInstance::FetchPageImpl(page_id_t page_id) { return FetchPageImpl(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // 1.     Search the page table for the requested page (P).
+  // 1.1    If P exists, wait until it is resident, pin it and return it immediately.
+  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
+  //        Note that pages are always found from the free list first, unless a strategy has a ring frame to reuse.
+  // 2.     Insert P into the page table, so that concurrent fetchers of P wait for this load instead of starting one.
+  // 3.     Drop the latch, write R back if it is dirty, then delete R from the page table.
+  // 4.     Read in the page content from disk, mark P resident and wake up everyone waiting on the frame.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (FindResidentFrame(&lock, page_id, &frame_id)) {
+    Page *page = pages_ + frame_id;
+    page->pin_count_++;
+    TrackRecLSN(frame_id);
+    replacer_->Pin(frame_id);
+    replacer_->RecordAccess(frame_id);
+    num_hits_.fetch_add(1, std::memory_order_relaxed);
+    return page;
+  }
+  auto miss_start = std::chrono::steady_clock::now();
+  if (!FindVictimFrame(&frame_id, strategy)) {
+    return nullptr;
+  }
+  Page *page = pages_ + frame_id;
+  bool victim_dirty;
+  page_id_t victim_page_id = AssignFrame(frame_id, page_id, &victim_dirty);
+  if (strategy != nullptr) {
+    strategy->Remember(this, pool_size_, frame_id, page_id);
+  }
+  lock.unlock();
+
+  if (victim_page_id != INVALID_PAGE_ID) {
+    EvictVictim(frame_id, victim_page_id, victim_dirty);
+  }
+  ReadIn(page_id, page->data_);
+
+  RelockLatch(&lock);
+  frame_states_[frame_id] = FrameState::RESIDENT;
+  frame_cvs_[frame_id].notify_all();
+  lock.unlock();
+  RecordMiss(miss_start);
+  return page;
+}
+
+void BufferPoolManagerInstance::FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+  FetchPagesImpl(page_ids, pages, nullptr);
+}
+
+void BufferPoolManagerInstance::FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages,
+                                               BufferAccessStrategy *strategy) {
+  // 1.   Under one latch acquisition, pin every resident page and claim a frame for every missing one, the same way
+  //      FetchPageImpl does for a single page. A page whose frame is in the middle of another thread's I/O is put off
+  //      until step 4: waiting for it while this batch holds frames that are still loading could deadlock with a batch
+  //      that waits for ours.
+  // 2.   Drop the latch and write back the dirty victims.
+  // 3.   Take the missing pages the compressed page cache has from there, and read the rest from disk as one batch in
+  //      page id order. Then mark their frames resident and wake up everyone waiting.
+  // 4.   Fetch the pages that were put off one at a time.
+  struct Miss {
+    frame_id_t frame_id_;
+    page_id_t page_id_;
+    page_id_t victim_page_id_;
+    bool victim_dirty_;
+  };
+  std::vector<Miss> misses;
+  std::unordered_map<page_id_t, frame_id_t> loading;
+  std::vector<size_t> deferred;
+  auto miss_start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    page_id_t page_id = page_ids[i];
+    auto loading_iter = loading.find(page_id);
+    if (loading_iter != loading.end()) {
+      // The page is loaded by this batch already, it only needs one more pin.
+      (*pages)[i] = pages_ + loading_iter->second;
+      (*pages)[i]->pin_count_++;
+      continue;
+    }
+    auto iter = page_table_.find(page_id);
+    if (iter != page_table_.end()) {
+      frame_id_t frame_id = iter->second;
+      if (frame_states_[frame_id] != FrameState::RESIDENT) {
+        deferred.push_back(i);
+        continue;
+      }
+      (*pages)[i] = pages_ + frame_id;
+      (*pages)[i]->pin_count_++;
+      TrackRecLSN(frame_id);
+      replacer_->Pin(frame_id);
+      replacer_->RecordAccess(frame_id);
+      num_hits_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    frame_id_t frame_id;
+    if (!FindVictimFrame(&frame_id, strategy)) {
+      (*pages)[i] = nullptr;
+      continue;
+    }
+    Miss miss{frame_id, page_id, INVALID_PAGE_ID, false};
+    miss.victim_page_id_ = AssignFrame(frame_id, page_id, &miss.victim_dirty_);
+    if (strategy != nullptr) {
+      strategy->Remember(this, pool_size_, frame_id, page_id);
+    }
+    misses.push_back(miss);
+    loading[page_id] = frame_id;
+    (*pages)[i] = pages_ + frame_id;
+  }
+  lock.unlock();
+
+  for (const Miss &miss : misses) {
+    if (miss.victim_page_id_ != INVALID_PAGE_ID) {
+      EvictVictim(miss.frame_id_, miss.victim_page_id_, miss.victim_dirty_);
+    }
+  }
+  std::sort(misses.begin(), misses.end(), [](const Miss &a, const Miss &b) { return a.page_id_ < b.page_id_; });
+  std::vector<page_id_t> read_page_ids;
+  std::vector<char *> read_data;
+  for (const Miss &miss : misses) {
+    if (!ReadInFromCache(miss.page_id_, pages_[miss.frame_id_].data_)) {
+      read_page_ids.push_back(miss.page_id_);
+      read_data.push_back(pages_[miss.frame_id_].data_);
+    }
+  }
+  disk_manager_->ReadPages(read_page_ids, read_data);
+
+  if (!misses.empty()) {
+    RelockLatch(&lock);
+    for (const Miss &miss : misses) {
+      frame_states_[miss.frame_id_] = FrameState::RESIDENT;
+      frame_cvs_[miss.frame_id_].notify_all();
+    }
+    lock.unlock();
+    for (size_t i = 0; i < misses.size(); i++) {
+      RecordMiss(miss_start);
+    }
+  }
+  for (size_t i : deferred) {
+    (*pages)[i] = FetchPageImpl(page_ids[i], strategy);
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPageImpl(page_id_t page_id,
+                                                 const std::shared_ptr<BufferAccessStrategy> &strategy) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    if (prefetch_queue_.size() >= pool_size_) {
+      return;
+    }
+    if (!prefetch_thread_.joinable()) {
+      prefetch_thread_ = std::thread(&BufferPoolManagerInstance::RunPrefetcher, this);
+    }
+    prefetch_queue_.emplace_back(page_id, strategy);
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::RunPrefetcher() {
+  while (true) {
+    // Take the queued requests that share the strategy of the first one, so that their reads go out as one batch. The
+    // frames of a batch stay pinned until all of it is read, so a batch for a strategy must not be larger than its
+    // ring, or it would wrap around onto its own frames and take the rest from the pool. Without a strategy, a batch
+    // holds at most a quarter of the pool, as in FlushAllPagesImpl, so that foreground fetches still find a victim.
+    std::shared_ptr<BufferAccessStrategy> strategy;
+    std::vector<page_id_t> page_ids;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [this] { return stop_prefetching_ || !prefetch_queue_.empty(); });
+      if (stop_prefetching_) {
+        return;
+      }
+      strategy = prefetch_queue_.front().second;
+      size_t batch_size = strategy == nullptr ? std::clamp<size_t>(pool_size_ / 4, 1, IO_QUEUE_DEPTH)
+                                              : strategy->GetRing(this, pool_size_).capacity_;
+      while (!prefetch_queue_.empty() && prefetch_queue_.front().second == strategy && page_ids.size() < batch_size) {
+        page_ids.push_back(prefetch_queue_.front().first);
+        prefetch_queue_.pop_front();
+      }
+    }
+    {
+      // Someone fetched a page in the meantime, or it is resident anyway. Do not disturb its replacer position.
+      std::unique_lock<std::mutex> lock = LockLatch();
+      auto resident = [this](page_id_t page_id) { return page_table_.count(page_id) != 0; };
+      page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(), resident), page_ids.end());
+    }
+    // Load the pages the same way a fetch does, which also makes concurrent fetchers of them wait for these reads,
+    // then let go of them right away.
+    std::vector<Page *> pages(page_ids.size());
+    FetchPagesImpl(page_ids, &pages, strategy.get());
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      if (pages[i] != nullptr) {
+        UnpinPageImpl(page_ids[i], false);
+      }
+    }
+  }
+}
+
+bool BufferPoolManagerInstance::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (!FindResidentFrame(&lock, page_id, &frame_id)) {
+    return false;
+  }
+  Page *page = pages_ + frame_id;
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  // Nobody holds a pin on the page, so there is nothing to unpin.
+  if (page->pin_count_ == 0) {
+    return false;
+  }
+  page->pin_count_--;
+  if (page->pin_count_ == 0) {
+    UnpinFrame(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPageImpl(page_id_t page_id) {
+  // Make sure you call DiskManager::WritePage!
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (page_id == INVALID_PAGE_ID || !FindResidentFrame(&lock, page_id, &frame_id)) {
+    return false;
+  }
+  // Pin the page for the duration of the write, so that it cannot be evicted while the latch is released.
+  Page *page = pages_ + frame_id;
+  page->pin_count_++;
+  replacer_->Pin(frame_id);
+  lock.unlock();
+
+  WriteBack(page_id, page->data_);
+
+  RelockLatch(&lock);
+  page->pin_count_--;
+  if (page->pin_count_ == 0) {
+    UnpinFrame(frame_id);
+  }
+  return true;
+}
+
+Page *BufferPoolManagerInstance::NewPageImpl(page_id_t *page_id) {
+  // 0.   Make sure you call AllocatePage!
+  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
+  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
+  // 3.   Update P's metadata and add P to the page table. If the victim is dirty, write it back without the latch.
+  // 4.   Zero out memory, set the page ID output parameter and return a pointer to P.
+  //      P is dirty from the start, the page id may have been deleted and its old bytes still be on disk.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (!FindVictimFrame(&frame_id)) {
+    return nullptr;
+  }
+  *page_id = AllocatePage();
+  Page *page = pages_ + frame_id;
+  bool victim_dirty;
+  page_id_t victim_page_id = AssignFrame(frame_id, *page_id, &victim_dirty);
+  if (victim_page_id != INVALID_PAGE_ID) {
+    lock.unlock();
+    EvictVictim(frame_id, victim_page_id, victim_dirty);
+    RelockLatch(&lock);
+  }
+  page->ResetMemory();
+  page->is_dirty_ = true;
+  frame_states_[frame_id] = FrameState::RESIDENT;
+  frame_cvs_[frame_id].notify_all();
+  return page;
+}
+
+bool BufferPoolManagerInstance::DeletePageImpl(page_id_t page_id) {
+  // 0.   Make sure you call DiskManager::DeallocatePage!
+  // 1.   Search the page table for the requested page (P).
+  // 1.   If P does not exist, return true.
+  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
+  // 3.   Otherwise, P can be deleted. If P is dirty, write it back without the latch, the index still reads pages
+  //      it has handed to DeletePage. Then remove P from the page table, reset its metadata and return it to the
+  //      free list.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (!FindResidentFrame(&lock, page_id, &frame_id)) {
+    // A page that is not in the pool may still be in the compressed page cache. Any eviction of it into the cache has
+    // finished, the page would still be in the page table otherwise.
+    if (page_cache_ != nullptr) {
+      page_cache_->Erase(page_id);
+    }
+    disk_manager_->DeallocatePage(page_id);
+    return true;
+  }
+  Page *page = pages_ + frame_id;
+  if (page->pin_count_ > 0) {
+    return false;
+  }
+  replacer_->Remove(frame_id);
+  if (page->is_dirty_) {
+    frame_states_[frame_id] = FrameState::EVICTING;
+    lock.unlock();
+    WriteBack(page_id, page->data_);
+    RelockLatch(&lock);
+  }
+
+  page_table_.erase(page_id);
+  // Only now that the page is gone from the page table may NewPage hand out its id again.
+  disk_manager_->DeallocatePage(page_id);
+  page->is_dirty_ = false;
+  page->page_id_ = INVALID_PAGE_ID;
+  page->pin_count_ = 0;
+  page->ResetMemory();
+  frame_states_[frame_id] = FrameState::FREE;
+  frame_cvs_[frame_id].notify_all();
+  if (static_cast<size_t>(frame_id) < pool_size_) {
+    free_list_.push_back(frame_id);
+  } else {
+    resize_cv_.notify_all();
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::FlushAllPagesImpl() {
+  // 1.   Collect the resident pages that may differ from disk, by page id, so that pages adjacent in the file are
+  //      written together.
+  // 2.   A batch at a time, pin the pages and copy them, then write the copies without the latch. A batch holds at most
+  //      a quarter of the pool, so foreground requests still find a victim.
+  // 3.   Unpin the pages and mark them clean, unless someone else holds them or changed them meanwhile, as the
+  //      background writer does.
+  // 4.   Sync the db file once, after the last batch.
+  std::vector<std::pair<page_id_t, frame_id_t>> to_flush = CollectPagesToFlush();
+  size_t batch_size = std::max<size_t>(pool_size_ / 4, 1);
+  PageCopies copies = AllocatePageCopies(batch_size);
+  for (size_t begin = 0; begin < to_flush.size(); begin += batch_size) {
+    FlushBatch batch;
+    PinPagesToFlush(to_flush.begin() + begin, to_flush.begin() + std::min(begin + batch_size, to_flush.size()),
+                    copies.get(), &batch);
+    if (!batch.page_ids_.empty()) {
+      WriteBackPages(batch.page_ids_, batch.data_);
+      FinishFlush(batch);
+    }
+  }
+  disk_manager_->Sync();
+}
+
+std::vector<std::pair<page_id_t, frame_id_t>> BufferPoolManagerInstance::CollectPagesToFlush() {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  std::vector<std::pair<page_id_t, frame_id_t>> to_flush;
+  for (const auto &[page_id, frame_id] : page_table_) {
+    Page *page = pages_ + frame_id;
+    if (frame_states_[frame_id] == FrameState::RESIDENT && (page->is_dirty_ || page->pin_count_ > 0)) {
+      to_flush.emplace_back(page_id, frame_id);
+    }
+  }
+  lock.unlock();
+  std::sort(to_flush.begin(), to_flush.end());
+  return to_flush;
+}
+
+void BufferPoolManagerInstance::PinPagesToFlush(std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator begin,
+                                                std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator end,
+                                                char *copies, FlushBatch *batch) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (auto iter = begin; iter != end; ++iter) {
+    auto [page_id, frame_id] = *iter;
+    Page *page = pages_ + frame_id;
+    // The page may have been evicted or replaced since it was collected.
+    if (frame_states_[frame_id] != FrameState::RESIDENT || page->page_id_ != page_id) {
+      continue;
+    }
+    page->pin_count_++;
+    replacer_->Pin(frame_id);
+    char *copy = copies + batch->page_ids_.size() * PAGE_SIZE;
+    memcpy(copy, page->data_, PAGE_SIZE);
+    batch->frame_ids_.push_back(frame_id);
+    batch->page_ids_.push_back(page_id);
+    batch->data_.push_back(copy);
+  }
+}
+
+void BufferPoolManagerInstance::FinishFlush(const FlushBatch &batch) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (size_t i = 0; i < batch.frame_ids_.size(); i++) {
+    Page *page = pages_ + batch.frame_ids_[i];
+    if (page->pin_count_ == 1 && page->is_dirty_ && memcmp(page->data_, batch.data_[i], PAGE_SIZE) == 0) {
+      page->is_dirty_ = false;
+    }
+    page->pin_count_--;
+    if (page->pin_count_ == 0) {
+      UnpinFrame(batch.frame_ids_[i]);
+    }
+  }
+  num_dirty_writes_.fetch_add(batch.page_ids_.size(), std::memory_order_relaxed);
+}
+
+bool BufferPoolManagerInstance::FindResidentFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id,
+                                                  frame_id_t *frame_id) {
+  while (true) {
+    auto iter = page_table_.find(page_id);
+    if (iter == page_table_.end()) {
+      return false;
+    }
+    *frame_id = iter->second;
+    if (frame_states_[*frame_id] == FrameState::RESIDENT) {
+      return true;
+    }
+    // The frame is either still loading this page or writing it back before loading another one. Either way, the
+    // page table entry changes once the I/O completes, so wait for the frame and look again.
+    frame_cvs_[*frame_id].wait(*lock);
+  }
+}
+
+bool BufferPoolManagerInstance::FindVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy) {
+  if (strategy != nullptr) {
+    const BufferAccessStrategy::RingSlot *slot = strategy->NextSlot(this, pool_size_);
+    if (slot != nullptr) {
+      Page *page = pages_ + slot->frame_id_;
+      if (static_cast<size_t>(slot->frame_id_) < pool_size_ && page->page_id_ == slot->page_id_ &&
+          page->pin_count_ == 0 && frame_states_[slot->frame_id_] == FrameState::RESIDENT) {
+        replacer_->Remove(slot->frame_id_);
+        *frame_id = slot->frame_id_;
+        return true;
+      }
+    }
+  }
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  return PickReplacerVictim(frame_id);
+}
+
+bool BufferPoolManagerInstance::PickReplacerVictim(frame_id_t *frame_id) {
+  if (!replacer_->Victim(frame_id)) {
+    return false;
+  }
+  if (!enable_logging || log_manager_ == nullptr) {
+    return true;
+  }
+  // Stop at the first candidate that needs no log force, it is the one to take.
+  lsn_t persistent_lsn = log_manager_->GetPersistentLSN();
+  std::array<frame_id_t, VICTIM_CANDIDATES> candidates;
+  size_t num_candidates = 0;
+  candidates[num_candidates++] = *frame_id;
+  while (NeedsLogForce(candidates[num_candidates - 1], persistent_lsn) && num_candidates < candidates.size() &&
+         replacer_->Victim(&candidates[num_candidates])) {
+    num_candidates++;
+  }
+  size_t best = num_candidates - 1;
+  if (NeedsLogForce(candidates[best], persistent_lsn)) {
+    for (size_t i = 0; i < num_candidates; i++) {
+      if (pages_[candidates[i]].GetLSN() < pages_[candidates[best]].GetLSN()) {
+        best = i;
+      }
+    }
+  }
+  // Put the others back in the reverse order they came out in, which leaves the replacer as it was.
+  for (size_t i = num_candidates; i-- > 0;) {
+    if (i != best) {
+      replacer_->PutBack(candidates[i]);
+    }
+  }
+  *frame_id = candidates[best];
+  return true;
+}
+
+bool BufferPoolManagerInstance::NeedsLogForce(frame_id_t frame_id, lsn_t persistent_lsn) const {
+  Page *page = pages_ + frame_id;
+  return page->is_dirty_ && page->GetLSN() > persistent_lsn;
+}
+
+page_id_t BufferPoolManagerInstance::AssignFrame(frame_id_t frame_id, page_id_t page_id, bool *victim_dirty) {
+  Page *page = pages_ + frame_id;
+  page_id_t victim_page_id = page->page_id_;
+  bool write_back = page->is_dirty_;
+  if (write_back) {
+    evicting_rec_lsns_[victim_page_id] = rec_lsns_[frame_id];
+  }
+  // A clean victim can leave the page table right away, the copy on disk is up to date. A dirty one has to stay until
+  // it is written back, otherwise a concurrent fetch could read the stale copy from disk. With a compressed page cache,
+  // a clean one stays too until it is in the cache, so that a concurrent fetch finds it there instead of on disk.
+  bool evict = victim_page_id != INVALID_PAGE_ID && (write_back || page_cache_ != nullptr);
+  if (victim_page_id != INVALID_PAGE_ID) {
+    num_evictions_.fetch_add(1, std::memory_order_relaxed);
+    if (!evict) {
+      page_table_.erase(victim_page_id);
+    }
+  }
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = false;
+  TrackRecLSN(frame_id);
+  replacer_->Pin(frame_id);
+  replacer_->RecordAccess(frame_id);
+  page_table_[page_id] = frame_id;
+  frame_states_[frame_id] = evict ? FrameState::EVICTING : FrameState::LOADING;
+  if (write_back) {
+    num_foreground_writes_++;
+  }
+  *victim_dirty = write_back;
+  return evict ? victim_page_id : INVALID_PAGE_ID;
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size) {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(resize_latch_);
+  if (pool_size < pool_size_) {
+    Shrink(pool_size);
+    return true;
+  }
+  // Growing only hands out frames that were reserved all along, nothing in use moves.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (size_t i = pool_size_; i < pool_size; ++i) {
+    free_list_.emplace_back(static_cast<frame_id_t>(i));
+  }
+  pool_size_ = pool_size;
+  lock.unlock();
+  if (frames_registered_) {
+    frames_registered_ = disk_manager_->RegisterBuffers(arena_.GetFrame(0), pool_size * PAGE_SIZE);
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::Shrink(size_t pool_size) {
+  // 1.   Lower pool_size_ first, so that no new page is loaded into the retired frames. Take them off the free list
+  //      and out of the replacer, UnpinFrame keeps them out from now on.
+  // 2.   Sweep the retired frames. Evict every resident unpinned page, writing it back without the latch if it is
+  //      dirty. The frame is EVICTING meanwhile, so fetchers of the page wait for the write and then read it again.
+  // 3.   If some frames are still pinned or in the middle of I/O, wait until one of them is unpinned and sweep again.
+  // 4.   Register only the frames still in use, then give the memory of the retired frames back. A registered range
+  //      stays pinned in memory, it must not cover memory that is released.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  size_t old_pool_size = pool_size_;
+  pool_size_ = pool_size;
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  for (size_t i = pool_size; i < old_pool_size; ++i) {
+    replacer_->Remove(static_cast<frame_id_t>(i));
+  }
+  while (true) {
+    bool busy = false;
+    for (size_t i = pool_size; i < old_pool_size; ++i) {
+      auto frame_id = static_cast<frame_id_t>(i);
+      Page *page = pages_ + frame_id;
+      if (frame_states_[frame_id] == FrameState::FREE) {
+        continue;
+      }
+      if (frame_states_[frame_id] != FrameState::RESIDENT || page->pin_count_ != 0) {
+        busy = true;
+        continue;
+      }
+      page_id_t page_id = page->page_id_;
+      if (page->is_dirty_) {
+        frame_states_[frame_id] = FrameState::EVICTING;
+        lock.unlock();
+        WriteBack(page_id, page->data_);
+        RelockLatch(&lock);
+      }
+      page_table_.erase(page_id);
+      replacer_->Remove(frame_id);
+      page->is_dirty_ = false;
+      page->page_id_ = INVALID_PAGE_ID;
+      frame_states_[frame_id] = FrameState::FREE;
+      frame_cvs_[frame_id].notify_all();
+      num_evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!busy) {
+      break;
+    }
+    resize_cv_.wait(lock);
+  }
+  lock.unlock();
+  if (frames_registered_) {
+    frames_registered_ = disk_manager_->RegisterBuffers(arena_.GetFrame(0), pool_size * PAGE_SIZE);
+  }
+  arena_.Release(static_cast<frame_id_t>(pool_size), old_pool_size - pool_size);
+}
+
+void BufferPoolManagerInstance::StartBackgroundWriter(size_t low_watermark, size_t high_watermark) {
+  BUSTUB_ASSERT(low_watermark <= high_watermark, "The low watermark must not be above the high watermark.");
+  std::lock_guard<std::mutex> guard(bgwriter_latch_);
+  bgwriter_low_watermark_ = low_watermark;
+  bgwriter_high_watermark_ = std::min(high_watermark, pool_size_.load());
+  if (!bgwriter_thread_.joinable()) {
+    stop_bgwriter_ = false;
+    bgwriter_thread_ = std::thread(&BufferPoolManagerInstance::RunBackgroundWriter, this);
+  }
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  std::thread bgwriter_thread;
+  {
+    std::lock_guard<std::mutex> guard(bgwriter_latch_);
+    stop_bgwriter_ = true;
+    bgwriter_thread = std::move(bgwriter_thread_);
+  }
+  bgwriter_cv_.notify_all();
+  if (bgwriter_thread.joinable()) {
+    bgwriter_thread.join();
+  }
+}
+
+BackgroundWriterStats BufferPoolManagerInstance::GetBackgroundWriterStats() {
+  BackgroundWriterStats stats;
+  stats.pages_cleaned_ = num_pages_cleaned_;
+  stats.foreground_writes_ = num_foreground_writes_;
+  return stats;
+}
+
+void BufferPoolManagerInstance::RunBackgroundWriter() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(bgwriter_latch_);
+      bgwriter_cv_.wait_for(lock, bgwriter_interval, [this] { return stop_bgwriter_ || bgwriter_wakeup_; });
+      if (stop_bgwriter_) {
+        return;
+      }
+      bgwriter_wakeup_ = false;
+    }
+    CleanFrames();
+  }
+}
+
+void BufferPoolManagerInstance::CleanFrames() {
+  size_t low_watermark;
+  size_t high_watermark;
+  {
+    std::lock_guard<std::mutex> guard(bgwriter_latch_);
+    low_watermark = bgwriter_low_watermark_;
+    high_watermark = bgwriter_high_watermark_;
+  }
+
+  // 1.   Count the frames an eviction could take without writing. Stop if there are enough of them.
+  // 2.   Sweep on from where the last round stopped, until enough frames would be clean. Pin a batch of dirty unpinned
+  //      pages, never more than are still missing, and write copies of them as one batch without the latch. The pin
+  //      keeps an eviction from writing a newer version to disk that the stale copy would overwrite. A batch holds at
+  //      most IO_QUEUE_DEPTH pages and a quarter of the pool, so foreground requests still find a victim.
+  // 3.   Unpin the pages and mark them clean, unless someone else holds them or changed them meanwhile.
+  size_t batch_size = std::clamp<size_t>(pool_size_ / 4, 1, IO_QUEUE_DEPTH);
+  PageCopies copies = AllocatePageCopies(batch_size);
+  std::unique_lock<std::mutex> lock = LockLatch();
+  size_t num_clean = free_list_.size();
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (frame_states_[i] == FrameState::RESIDENT && pages_[i].pin_count_ == 0 && !pages_[i].is_dirty_) {
+      num_clean++;
+    }
+  }
+  if (num_clean >= low_watermark) {
+    return;
+  }
+  size_t step = 0;
+  while (step < pool_size_ && num_clean < high_watermark) {
+    std::vector<frame_id_t> frame_ids;
+    std::vector<page_id_t> page_ids;
+    std::vector<const char *> data;
+    for (; step < pool_size_ && num_clean + frame_ids.size() < high_watermark && frame_ids.size() < batch_size;
+         step++) {
+      if (bgwriter_cursor_ >= pool_size_) {
+        bgwriter_cursor_ = 0;
+      }
+      auto frame_id = static_cast<frame_id_t>(bgwriter_cursor_);
+      bgwriter_cursor_ = (bgwriter_cursor_ + 1) % pool_size_;
+      Page *page = pages_ + frame_id;
+      if (frame_states_[frame_id] != FrameState::RESIDENT || page->pin_count_ != 0 || !page->is_dirty_) {
+        continue;
+      }
+      page->pin_count_++;
+      replacer_->Pin(frame_id);
+      char *copy = copies.get() + frame_ids.size() * PAGE_SIZE;
+      memcpy(copy, page->data_, PAGE_SIZE);
+      frame_ids.push_back(frame_id);
+      page_ids.push_back(page->page_id_);
+      data.push_back(copy);
+    }
+    if (frame_ids.empty()) {
+      break;
+    }
+
+    lock.unlock();
+    WriteBackPages(page_ids, data);
+    num_dirty_writes_.fetch_add(page_ids.size(), std::memory_order_relaxed);
+    RelockLatch(&lock);
+
+    for (size_t i = 0; i < frame_ids.size(); i++) {
+      Page *page = pages_ + frame_ids[i];
+      if (page->pin_count_ == 1 && page->is_dirty_ && memcmp(page->data_, data[i], PAGE_SIZE) == 0) {
+        page->is_dirty_ = false;
+        num_pages_cleaned_++;
+        num_clean++;
+      }
+      page->pin_count_--;
+      if (page->pin_count_ == 0) {
+        UnpinFrame(frame_ids[i]);
+      }
+    }
+  }
+}
+
+BufferPoolStats BufferPoolManagerInstance::GetStats() {
+  BufferPoolStats stats;
+  stats.hits_ = num_hits_.load(std::memory_order_relaxed);
+  stats.misses_ = num_misses_.load(std::memory_order_relaxed);
+  stats.evictions_ = num_evictions_.load(std::memory_order_relaxed);
+  stats.dirty_writes_ = num_dirty_writes_.load(std::memory_order_relaxed);
+  stats.log_forces_ = num_log_forces_.load(std::memory_order_relaxed);
+  stats.compressed_hits_ = num_compressed_hits_.load(std::memory_order_relaxed);
+  stats.latch_wait_ns_ = latch_wait_ns_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < BufferPoolStats::NUM_LATENCY_BUCKETS; i++) {
+    stats.miss_latency_histogram_[i] = miss_latency_histogram_[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void BufferPoolManagerInstance::ResetStats() {
+  num_hits_.store(0, std::memory_order_relaxed);
+  num_misses_.store(0, std::memory_order_relaxed);
+  num_evictions_.store(0, std::memory_order_relaxed);
+  num_dirty_writes_.store(0, std::memory_order_relaxed);
+  num_log_forces_.store(0, std::memory_order_relaxed);
+  num_compressed_hits_.store(0, std::memory_order_relaxed);
+  latch_wait_ns_.store(0, std::memory_order_relaxed);
+  for (auto &bucket : miss_latency_histogram_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::unordered_map<page_id_t, lsn_t> BufferPoolManagerInstance::GetDirtyPageTable() {
+  // Only the metadata is read under the latch, nothing waits for a frame that is loading or being written back. A dirty
+  // page stays in the table until its write back is done: as long as it is in its frame, or in evicting_rec_lsns_. The
+  // pinned pages count as dirty, as in FlushAllPagesImpl, their holders may have changed them without telling yet.
+  std::unique_lock<std::mutex> lock = LockLatch();
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table = evicting_rec_lsns_;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && (pages_[i].is_dirty_ || pages_[i].pin_count_ > 0)) {
+      dirty_page_table[pages_[i].page_id_] = rec_lsns_[i];
+    }
+  }
+  return dirty_page_table;
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+  RelockLatch(&lock);
+  return lock;
+}
+
+void BufferPoolManagerInstance::RelockLatch(std::unique_lock<std::mutex> *lock) {
+  // Only read the clock when the latch is contended, an uncontended acquisition stays as cheap as before.
+  if (lock->try_lock()) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  lock->lock();
+  auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  latch_wait_ns_.fetch_add(wait.count(), std::memory_order_relaxed);
+}
+
+void BufferPoolManagerInstance::ForceLog(lsn_t lsn) {
+  if (!enable_logging || log_manager_ == nullptr || lsn <= log_manager_->GetPersistentLSN()) {
+    return;
+  }
+  log_manager_->FlushUntil(lsn);
+  num_log_forces_.fetch_add(1, std::memory_order_relaxed);
+}
+
+lsn_t BufferPoolManagerInstance::PageLSN(const char *data) {
+  lsn_t lsn;
+  memcpy(&lsn, data + Page::OFFSET_LSN, sizeof(lsn));
+  return lsn;
+}
+
+void BufferPoolManagerInstance::TrackRecLSN(frame_id_t frame_id) {
+  Page *page = pages_ + frame_id;
+  if (page->pin_count_ == 1 && !page->is_dirty_) {
+    rec_lsns_[frame_id] = log_manager_ != nullptr ? log_manager_->GetNextLSN() : INVALID_LSN;
+  }
+}
+
+void BufferPoolManagerInstance::WriteBack(page_id_t page_id, const char *data) {
+  ForceLog(PageLSN(data));
+  disk_manager_->WritePage(page_id, data);
+  num_dirty_writes_.fetch_add(1, std::memory_order_relaxed);
+}
+
+BufferPoolManagerInstance::PageCopies BufferPoolManagerInstance::AllocatePageCopies(size_t num_pages) {
+  return PageCopies(static_cast<char *>(::operator new[](num_pages * PAGE_SIZE, std::align_val_t{PAGE_SIZE})));
+}
+
+void BufferPoolManagerInstance::WriteBackPages(const std::vector<page_id_t> &page_ids,
+                                               const std::vector<const char *> &data) {
+  lsn_t lsn = INVALID_LSN;
+  for (const char *page_data : data) {
+    lsn = std::max(lsn, PageLSN(page_data));
+  }
+  ForceLog(lsn);
+  disk_manager_->WritePages(page_ids, data);
+}
+
+void BufferPoolManagerInstance::RecordMiss(std::chrono::steady_clock::time_point start) {
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  size_t bucket = 0;
+  while (bucket + 1 < BufferPoolStats::NUM_LATENCY_BUCKETS && (1LL << bucket) <= latency.count()) {
+    bucket++;
+  }
+  miss_latency_histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+  num_misses_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BufferPoolManagerInstance::WakeBackgroundWriter() {
+  {
+    std::lock_guard<std::mutex> guard(bgwriter_latch_);
+    if (!bgwriter_thread_.joinable()) {
+      return;
+    }
+    bgwriter_wakeup_ = true;
+  }
+  bgwriter_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  if (static_cast<size_t>(frame_id) < pool_size_) {
+    replacer_->Unpin(frame_id);
+  } else {
+    resize_cv_.notify_all();
+  }
+}
+
+void BufferPoolManagerInstance::EvictVictim(frame_id_t frame_id, page_id_t victim_page_id, bool victim_dirty) {
+  const char *data = pages_[frame_id].data_;
+  if (victim_dirty) {
+    WriteBack(victim_page_id, data);
+  }
+  if (page_cache_ != nullptr) {
+    page_cache_->Insert(victim_page_id, data);
+  }
+  FinishEviction(frame_id, victim_page_id);
+  if (victim_dirty) {
+    WakeBackgroundWriter();
+  }
+}
+
+void BufferPoolManagerInstance::ReadIn(page_id_t page_id, char *data) {
+  if (!ReadInFromCache(page_id, data)) {
+    disk_manager_->ReadPage(page_id, data);
+  }
+}
+
+bool BufferPoolManagerInstance::ReadInFromCache(page_id_t page_id, char *data) {
+  if (page_cache_ == nullptr || !page_cache_->Take(page_id, data)) {
+    return false;
+  }
+  num_compressed_hits_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void BufferPoolManagerInstance::FinishEviction(frame_id_t frame_id, page_id_t victim_page_id) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  page_table_.erase(victim_page_id);
+  evicting_rec_lsns_.erase(victim_page_id);
+  frame_states_[frame_id] = FrameState::LOADING;
+  frame_cvs_[frame_id].notify_all();
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage() {
+  // A reader that looked up a page id before the page was deleted may still fetch the deleted page. Its id stays
+  // allocated while it is in the page table, the next free page is taken instead.
+  std::vector<page_id_t> resident_page_ids;
+  page_id_t next_page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  while (page_table_.find(next_page_id) != page_table_.end()) {
+    resident_page_ids.push_back(next_page_id);
+    next_page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  }
+  for (page_id_t page_id : resident_page_ids) {
+    disk_manager_->DeallocatePage(page_id);
+  }
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  // Allocated pages must map back to this instance, otherwise the parallel pool would route them elsewhere.
+  assert(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_);
+}
+
+}  // namespace bustub
@@ -12,18 +12,71 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages), frame_states_(num_pages) {
+  for (auto &state : frame_states_) {
+    state.store(0, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  // Sweep the clock until an unreferenced evictable frame is claimed. Every full sweep clears the reference bits it
+  // passes, so the sweep ends after at most two laps unless other threads keep unpinning frames concurrently.
+  while (size_.load() > 0) {
+    size_t index = clock_hand_.fetch_add(1) % num_pages_;
+    std::atomic<uint8_t> &state = frame_states_[index];
+    uint8_t current = state.load();
+    if ((current & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      // Second chance, a failed exchange means the frame was pinned or touched meanwhile, which is fine too.
+      state.compare_exchange_strong(current, current & ~REFERENCED);
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0)) {
+      size_--;
+      *frame_id = static_cast<frame_id_t>(index);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  uint8_t previous = frame_states_[frame_id].fetch_and(static_cast<uint8_t>(~(EVICTABLE | REFERENCED)));
+  if ((previous & EVICTABLE) != 0) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  uint8_t previous = frame_states_[frame_id].fetch_or(EVICTABLE | REFERENCED);
+  if ((previous & EVICTABLE) == 0) {
+    size_++;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::PutBack(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Frame id out of range.");
+  // Victim only takes unreferenced frames. Without the reference bit the frame goes the next time the hand passes it,
+  // the clock keeps no order beyond that.
+  uint8_t previous = frame_states_[frame_id].fetch_or(EVICTABLE);
+  if ((previous & EVICTABLE) == 0) {
+    size_++;
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() {
+  int64_t size = size_.load();
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
 
 }  // namespace bustub
@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+/** Shortest back reference worth encoding. */
+constexpr size_t MIN_MATCH = 4;
+/** Number of bits of the hash of four bytes, the match finder remembers one position per hash. */
+constexpr size_t HASH_BITS = 12;
+
+inline uint32_t Load32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline size_t Hash(uint32_t value) { return (value * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append a length that did not fit into the nibble of the token, as a run of 255s and a last byte below 255. */
+inline void PutLength(size_t length, std::vector<char> *out) {
+  while (length >= 255) {
+    out->push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  out->push_back(static_cast<char>(length));
+}
+
+/** Read a length that did not fit into the nibble of the token. */
+inline bool GetLength(const std::vector<char> &in, size_t *pos, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*pos >= in.size()) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(in[(*pos)++]);
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Append one sequence: a token with the literal length in the high and the match length in the low nibble, the
+ * literals, and the offset of the match unless match_length is 0, which marks the last sequence.
+ */
+void PutSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length,
+                 std::vector<char> *out) {
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  auto token = static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+  out->push_back(static_cast<char>(token));
+  if (literal_length >= 15) {
+    PutLength(literal_length - 15, out);
+  }
+  out->insert(out->end(), literals, literals + literal_length);
+  if (match_length == 0) {
+    return;
+  }
+  out->push_back(static_cast<char>(offset & 0xff));
+  out->push_back(static_cast<char>(offset >> 8));
+  if (match_code >= 15) {
+    PutLength(match_code - 15, out);
+  }
+}
+
+}  // namespace
+
+CompressedPageCache::CompressedPageCache(size_t budget) : budget_(budget) {}
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  std::vector<char> compressed;
+  if (!Compress(data, &compressed) || compressed.size() > budget_) {
+    Erase(page_id);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    EraseEntry(iter);
+  }
+  while (size_ + compressed.size() > budget_) {
+    EraseEntry(entries_.find(lru_list_.front()));
+  }
+  size_ += compressed.size();
+  lru_list_.push_back(page_id);
+  entries_.emplace(page_id, Entry{std::prev(lru_list_.end()), std::move(compressed)});
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *data) {
+  std::vector<char> compressed;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto iter = entries_.find(page_id);
+    if (iter == entries_.end()) {
+      return false;
+    }
+    compressed = EraseEntry(iter);
+  }
+  bool decompressed = Decompress(compressed, data);
+  BUSTUB_ASSERT(decompressed, "A page in the compressed page cache is corrupt.");
+  return decompressed;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    EraseEntry(iter);
+  }
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return entries_.size();
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+std::vector<char> CompressedPageCache::EraseEntry(std::unordered_map<page_id_t, Entry>::iterator iter) {
+  std::vector<char> compressed = std::move(iter->second.data_);
+  size_ -= compressed.size();
+  lru_list_.erase(iter->second.lru_iter_);
+  entries_.erase(iter);
+  return compressed;
+}
+
+bool CompressedPageCache::Compress(const char *data, std::vector<char> *compressed) {
+  // Greedy LZ77: remember the last position of every hash of four bytes, and whenever the four bytes at the current
+  // position match the remembered ones, extend the match as far as it goes. A run of equal bytes matches itself one
+  // byte back, so it costs a single sequence.
+  compressed->clear();
+  compressed->reserve(PAGE_SIZE);
+  int32_t table[1 << HASH_BITS];
+  for (auto &position : table) {
+    position = -1;
+  }
+  size_t pos = 0;
+  size_t anchor = 0;
+  while (pos + MIN_MATCH <= static_cast<size_t>(PAGE_SIZE)) {
+    uint32_t sequence = Load32(data + pos);
+    size_t hash = Hash(sequence);
+    int32_t ref = table[hash];
+    table[hash] = static_cast<int32_t>(pos);
+    if (ref < 0 || Load32(data + ref) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match_length = MIN_MATCH;
+    while (pos + match_length < static_cast<size_t>(PAGE_SIZE) &&
+           data[ref + match_length] == data[pos + match_length]) {
+      match_length++;
+    }
+    PutSequence(data + anchor, pos - anchor, pos - ref, match_length, compressed);
+    pos += match_length;
+    anchor = pos;
+    if (compressed->size() >= static_cast<size_t>(PAGE_SIZE)) {
+      return false;
+    }
+  }
+  PutSequence(data + anchor, PAGE_SIZE - anchor, 0, 0, compressed);
+  return compressed->size() < static_cast<size_t>(PAGE_SIZE);
+}
+
+bool CompressedPageCache::Decompress(const std::vector<char> &compressed, char *data) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < compressed.size()) {
+    auto token = static_cast<uint8_t>(compressed[in++]);
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !GetLength(compressed, &in, &literal_length)) {
+      return false;
+    }
+    if (in + literal_length > compressed.size() || out + literal_length > static_cast<size_t>(PAGE_SIZE)) {
+      return false;
+    }
+    memcpy(data + out, compressed.data() + in, literal_length);
+    in += literal_length;
+    out += literal_length;
+    if (in == compressed.size()) {
+      break;
+    }
+    if (in + 2 > compressed.size()) {
+      return false;
+    }
+    size_t offset = static_cast<uint8_t>(compressed[in]) |
+                    static_cast<size_t>(static_cast<uint8_t>(compressed[in + 1])) << 8;
+    in += 2;
+    size_t match_length = token & 0xf;
+    if (match_length == 15 && !GetLength(compressed, &in, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > out || out + match_length > static_cast<size_t>(PAGE_SIZE)) {
+      return false;
+    }
+    // The match may overlap the bytes it produces, so copy byte by byte.
+    for (size_t i = 0; i < match_length; i++, out++) {
+      data[out] = data[out - offset];
+    }
+  }
+  return out == static_cast<size_t>(PAGE_SIZE);
+}
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <new>
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames) : size_(num_frames * PAGE_SIZE) {
+  BUSTUB_ASSERT(num_frames > 0, "An arena holds at least one frame.");
+  size_t alignment = PAGE_SIZE;
+  if (size_ >= static_cast<size_t>(HUGE_PAGE_SIZE)) {
+    // Round up to whole huge pages, only a large arena is worth the waste of the last partial one.
+    alignment = HUGE_PAGE_SIZE;
+    size_ = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    // Explicit huge pages only exist if the administrator reserved some, so this usually falls through.
+    void *mapping = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping != MAP_FAILED) {
+      data_ = static_cast<char *>(mapping);
+      is_huge_tlb_ = true;
+      return;
+    }
+#endif
+  }
+  // Anonymous memory is zeroed and only backed once it is touched. mmap aligns to the base page size, so reserve
+  // enough to find an aligned start in the mapping and unmap the slack around it.
+  size_t reserved = size_ + alignment - PAGE_SIZE;
+  void *mapping = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  auto start = reinterpret_cast<uintptr_t>(mapping);
+  auto aligned = (start + alignment - 1) / alignment * alignment;
+  if (aligned > start) {
+    munmap(mapping, aligned - start);
+  }
+  if (aligned + size_ < start + reserved) {
+    munmap(reinterpret_cast<void *>(aligned + size_), start + reserved - aligned - size_);
+  }
+  data_ = reinterpret_cast<char *>(aligned);
+#ifdef MADV_HUGEPAGE
+  if (alignment == static_cast<size_t>(HUGE_PAGE_SIZE)) {
+    // Ask for transparent huge pages. This is only advice, the arena works the same without them.
+    madvise(data_, size_, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+FrameArena::~FrameArena() { munmap(data_, size_); }
+
+void FrameArena::Release(frame_id_t first_frame_id, size_t num_frames) {
+  if (is_huge_tlb_ || num_frames == 0) {
+    return;
+  }
+  madvise(GetFrame(first_frame_id), num_frames * PAGE_SIZE, MADV_DONTNEED);
+}
+
+}  // namespace bustub
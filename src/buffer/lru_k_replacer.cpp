@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : max_capacity_(num_pages), k_(k) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to remember at least one access per frame.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  // Scan for the frame with the largest backward K-distance. A frame with fewer than K accesses beats every frame
+  // with K of them, ties are broken by the oldest remembered access. Frames that were never accessed count as older
+  // than everything else.
+  auto victim = frames_.end();
+  bool victim_infinite = false;
+  size_t victim_timestamp = 0;
+  for (auto iter = frames_.begin(); iter != frames_.end(); ++iter) {
+    const FrameEntry &entry = iter->second;
+    if (!entry.evictable_) {
+      continue;
+    }
+    bool infinite = entry.history_.size() < k_;
+    size_t timestamp = entry.history_.empty() ? 0 : entry.history_.front();
+    if (victim == frames_.end() || (infinite && !victim_infinite) ||
+        (infinite == victim_infinite && timestamp < victim_timestamp)) {
+      victim = iter;
+      victim_infinite = infinite;
+      victim_timestamp = timestamp;
+    }
+  }
+  if (victim == frames_.end()) {
+    return false;
+  }
+  *frame_id = victim->first;
+  victims_[victim->first] = std::move(victim->second.history_);
+  frames_.erase(victim);
+  curr_size_--;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto iter = frames_.find(frame_id);
+  if (iter != frames_.end() && iter->second.evictable_) {
+    iter->second.evictable_ = false;
+    curr_size_--;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    return;
+  }
+  BUSTUB_ASSERT(curr_size_ < max_capacity_, "LRUKReplacer tracks more frames than it was created for.");
+  entry.evictable_ = true;
+  curr_size_++;
+}
+
+void LRUKReplacer::PutBack(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  if (entry.evictable_) {
+    return;
+  }
+  auto iter = victims_.find(frame_id);
+  if (iter != victims_.end()) {
+    entry.history_ = std::move(iter->second);
+    victims_.erase(iter);
+  }
+  entry.evictable_ = true;
+  curr_size_++;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameEntry &entry = frames_[frame_id];
+  entry.history_.push_back(current_timestamp_++);
+  if (entry.history_.size() > k_) {
+    entry.history_.pop_front();
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  victims_.erase(frame_id);
+  auto iter = frames_.find(frame_id);
+  if (iter == frames_.end()) {
+    return;
+  }
+  if (iter->second.evictable_) {
+    curr_size_--;
+  }
+  frames_.erase(iter);
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return curr_size_;
+}
+
+}  // namespace bustub
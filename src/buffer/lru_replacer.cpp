@@ -12,6 +12,8 @@
 
 #include "buffer/lru_replacer.h"
 
+#include <iterator>
+
 namespace bustub {
 
 LRUReplacer::LRUReplacer(size_t num_pages) : max_capacity_(num_pages) {
@@ -62,6 +64,16 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   // latch_.unlock();
 }
 
+void LRUReplacer::PutBack(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (lru_map_.count(frame_id) != 0) {
+    return;
+  }
+  // Victim takes from the back, so that is where the frame was.
+  frame_list_.push_back(frame_id);
+  lru_map_.insert(std::make_pair(frame_id, std::prev(frame_list_.end())));
+}
+
 size_t LRUReplacer::Size() { return frame_list_.size(); }
 
 }  // namespace bustub
@@ -0,0 +1,260 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     size_t max_pool_size, size_t compressed_cache_size) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel buffer pool needs at least one instance.");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(
+        new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager, replacer_policy,
+                                      max_pool_size, compressed_cache_size));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t pool_size) {
+  size_t num_instances = instances_.size();
+  size_t instance_pool_size = (pool_size + num_instances - 1) / num_instances;
+  // Check every instance before touching any, so that a failed resize leaves the pool as it was.
+  for (auto *instance : instances_) {
+    if (instance_pool_size == 0 || instance_pool_size > instance->GetMaxPoolSize()) {
+      return false;
+    }
+  }
+  for (auto *instance : instances_) {
+    instance->Resize(instance_pool_size);
+  }
+  return true;
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(size_t low_watermark, size_t high_watermark) {
+  size_t num_instances = instances_.size();
+  for (auto *instance : instances_) {
+    instance->StartBackgroundWriter((low_watermark + num_instances - 1) / num_instances,
+                                    (high_watermark + num_instances - 1) / num_instances);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+BackgroundWriterStats ParallelBufferPoolManager::GetBackgroundWriterStats() {
+  BackgroundWriterStats stats;
+  for (auto *instance : instances_) {
+    BackgroundWriterStats instance_stats = instance->GetBackgroundWriterStats();
+    stats.pages_cleaned_ += instance_stats.pages_cleaned_;
+    stats.foreground_writes_ += instance_stats.foreground_writes_;
+  }
+  return stats;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    BufferPoolStats instance_stats = instance->GetStats();
+    stats.hits_ += instance_stats.hits_;
+    stats.misses_ += instance_stats.misses_;
+    stats.evictions_ += instance_stats.evictions_;
+    stats.dirty_writes_ += instance_stats.dirty_writes_;
+    stats.log_forces_ += instance_stats.log_forces_;
+    stats.compressed_hits_ += instance_stats.compressed_hits_;
+    stats.latch_wait_ns_ += instance_stats.latch_wait_ns_;
+    for (size_t i = 0; i < BufferPoolStats::NUM_LATENCY_BUCKETS; i++) {
+      stats.miss_latency_histogram_[i] += instance_stats.miss_latency_histogram_[i];
+    }
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::ResetStats() {
+  for (auto *instance : instances_) {
+    instance->ResetStats();
+  }
+}
+
+std::unordered_map<page_id_t, lsn_t> ParallelBufferPoolManager::GetDirtyPageTable() {
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table;
+  for (auto *instance : instances_) {
+    std::unordered_map<page_id_t, lsn_t> instance_table = instance->GetDirtyPageTable();
+    dirty_page_table.insert(instance_table.begin(), instance_table.end());
+  }
+  return dirty_page_table;
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  std::vector<std::vector<size_t>> instance_positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    size_t instance_index = static_cast<size_t>(page_ids[i]) % instances_.size();
+    instance_page_ids[instance_index].push_back(page_ids[i]);
+    instance_positions[instance_index].push_back(i);
+  }
+  for (size_t instance_index = 0; instance_index < instances_.size(); instance_index++) {
+    if (instance_page_ids[instance_index].empty()) {
+      continue;
+    }
+    std::vector<Page *> instance_pages = instances_[instance_index]->FetchPages(instance_page_ids[instance_index]);
+    for (size_t j = 0; j < instance_pages.size(); j++) {
+      (*pages)[instance_positions[instance_index][j]] = instance_pages[j];
+    }
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPageImpl(page_id_t page_id,
+                                                 const std::shared_ptr<BufferAccessStrategy> &strategy) {
+  if (page_id != INVALID_PAGE_ID) {
+    GetBufferPoolManager(page_id)->PrefetchPage(page_id, strategy);
+  }
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  // 1.   Bump the starting index so that the next call starts its search at a different instance.
+  // 2.   Ask every instance once, beginning at the starting index, and return the first page that could be created.
+  // 3.   If every instance is full of pinned pages, return nullptr.
+  size_t start;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    start = start_index_;
+    start_index_ = (start_index_ + 1) % instances_.size();
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    Page *page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  // 1.   Collect the pages to flush of every instance, and order them by page id across all instances, so that pages
+  //      adjacent in the file are written together even though they belong to different instances.
+  // 2.   A batch at a time, pin and copy the pages in their instances, write all of them as one batch, then let every
+  //      instance unpin its own. A batch takes at most a quarter of the pool of every instance.
+  // 3.   Sync the db file once, after the last batch.
+  struct ToFlush {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    size_t instance_;
+  };
+  std::vector<ToFlush> to_flush;
+  std::vector<size_t> batch_sizes;
+  size_t batch_size = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    for (const auto &[page_id, frame_id] : instances_[i]->CollectPagesToFlush()) {
+      to_flush.push_back(ToFlush{page_id, frame_id, i});
+    }
+    batch_sizes.push_back(std::max<size_t>(instances_[i]->GetPoolSize() / 4, 1));
+    batch_size += batch_sizes.back();
+  }
+  std::sort(to_flush.begin(), to_flush.end(),
+            [](const ToFlush &a, const ToFlush &b) { return a.page_id_ < b.page_id_; });
+
+  BufferPoolManagerInstance::PageCopies copies = BufferPoolManagerInstance::AllocatePageCopies(batch_size);
+  size_t begin = 0;
+  while (begin < to_flush.size()) {
+    // Take pages in order until the next one would go beyond the share of its instance.
+    std::vector<std::vector<std::pair<page_id_t, frame_id_t>>> shares(instances_.size());
+    for (; begin < to_flush.size(); begin++) {
+      const ToFlush &page = to_flush[begin];
+      if (shares[page.instance_].size() >= batch_sizes[page.instance_]) {
+        break;
+      }
+      shares[page.instance_].emplace_back(page.page_id_, page.frame_id_);
+    }
+
+    std::vector<BufferPoolManagerInstance::FlushBatch> batches(instances_.size());
+    size_t num_copies = 0;
+    for (size_t i = 0; i < instances_.size(); i++) {
+      instances_[i]->PinPagesToFlush(shares[i].begin(), shares[i].end(), copies.get() + num_copies * PAGE_SIZE,
+                                     &batches[i]);
+      num_copies += batches[i].page_ids_.size();
+    }
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    for (const auto &batch : batches) {
+      for (size_t j = 0; j < batch.page_ids_.size(); j++) {
+        pages.emplace_back(batch.page_ids_[j], batch.data_[j]);
+      }
+    }
+    if (pages.empty()) {
+      continue;
+    }
+    std::sort(pages.begin(), pages.end());
+    std::vector<page_id_t> page_ids;
+    std::vector<const char *> data;
+    for (const auto &[page_id, page_data] : pages) {
+      page_ids.push_back(page_id);
+      data.push_back(page_data);
+    }
+    // The instances share the disk manager and the log manager, any of them can write the batch.
+    instances_.front()->WriteBackPages(page_ids, data);
+    for (size_t i = 0; i < instances_.size(); i++) {
+      if (!batches[i].page_ids_.empty()) {
+        instances_[i]->FinishFlush(batches[i]);
+      }
+    }
+  }
+  instances_.front()->disk_manager_->Sync();
+}
+
+}  // namespace bustub
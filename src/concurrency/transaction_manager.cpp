@@ -30,7 +30,18 @@ Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolatio
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
 
-  txn_map[txn->GetTransactionId()] = txn;
+  // The transaction is in the active transaction table before its begin record is in the log, so that a checkpoint
+  // that ends after the begin record lists it.
+  {
+    std::lock_guard<std::mutex> guard(active_txns_latch_);
+    active_txns_[txn->GetTransactionId()] = txn;
+    txn_map[txn->GetTransactionId()] = txn;
+  }
+
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
   return txn;
 }
 
@@ -51,6 +62,20 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  // The transaction is committed once its commit record is on disk. Commits that wait at the same time share one flush.
+  // An async commit only makes sure that the flush thread gets to it in time.
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+    if (txn->IsAsyncCommit()) {
+      log_manager_->FlushLazily(lsn);
+    } else {
+      log_manager_->FlushUntil(lsn);
+    }
+  }
+  RemoveActiveTransaction(txn);
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -105,12 +130,32 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+  RemoveActiveTransaction(txn);
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
 
+std::unordered_map<txn_id_t, lsn_t> TransactionManager::GetActiveTransactionTable() {
+  std::lock_guard<std::mutex> guard(active_txns_latch_);
+  std::unordered_map<txn_id_t, lsn_t> active_txn_table;
+  for (const auto &[txn_id, txn] : active_txns_) {
+    active_txn_table[txn_id] = txn->GetPrevLSN();
+  }
+  return active_txn_table;
+}
+
+void TransactionManager::RemoveActiveTransaction(Transaction *txn) {
+  std::lock_guard<std::mutex> guard(active_txns_latch_);
+  active_txns_.erase(txn->GetTransactionId());
+}
+
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
@@ -32,38 +32,62 @@ void NestIndexJoinExecutor::Init() {
   if (child_executor_ != nullptr) {
     child_executor_->Init();
   }
+  outer_batch_.clear();
+  inner_rids_.clear();
+  inner_batch_.clear();
+  batch_pos_ = 0;
 }
 
 bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) {
-  while (child_executor_->Next(tuple, rid)) {
-    // 构建outer_table的key索引
-    Tuple outer_key({tuple->GetValue(outer_table_schema_, outer_col_idx_)}, &inner_index_info_->key_schema_);
+  while (true) {
+    // Probe the index for a batch of outer tuples first and read all the inner tuples they matched together, so that
+    // the inner table is not read one random page miss per outer tuple.
+    if (batch_pos_ == outer_batch_.size()) {
+      outer_batch_.clear();
+      inner_rids_.clear();
+      Tuple outer_tuple;
+      RID outer_rid;
+      while (outer_batch_.size() < static_cast<size_t>(FETCH_BATCH_SIZE) &&
+             child_executor_->Next(&outer_tuple, &outer_rid)) {
+        // 构建outer_table的key索引
+        Tuple outer_key({outer_tuple.GetValue(outer_table_schema_, outer_col_idx_)}, &inner_index_info_->key_schema_);
 
-    std::vector<RID> find_result;
-    inner_index_info_->index_->ScanKey(outer_key, &find_result, exec_ctx_->GetTransaction());
-    if (find_result.empty()) {
-      return false;
+        std::vector<RID> find_result;
+        inner_index_info_->index_->ScanKey(outer_key, &find_result, exec_ctx_->GetTransaction());
+        if (find_result.empty()) {
+          continue;
+        }
+        outer_batch_.push_back(outer_tuple);
+        inner_rids_.push_back(find_result[0]);
+      }
+      if (outer_batch_.empty()) {
+        return false;
+      }
+      inner_table_info_->table_->GetTuples(inner_rids_, &inner_batch_, exec_ctx_->GetTransaction());
+      batch_pos_ = 0;
     }
 
-    RID *target_rid = &(find_result[0]);
-    Tuple inner_tuple;
-    inner_table_info_->table_->GetTuple(*target_rid, &inner_tuple, exec_ctx_->GetTransaction());
-
+    Tuple *outer_tuple = &outer_batch_[batch_pos_];
+    Tuple *inner_tuple = &inner_batch_[batch_pos_];
+    batch_pos_++;
+    if (!inner_tuple->IsAllocated()) {
+      continue;
+    }
     if (plan_->Predicate() == nullptr ||
-        plan_->Predicate()->EvaluateJoin(tuple, outer_table_schema_, &inner_tuple, inner_table_schema_).GetAs<bool>()) {
+        plan_->Predicate()
+            ->EvaluateJoin(outer_tuple, outer_table_schema_, inner_tuple, inner_table_schema_)
+            .GetAs<bool>()) {
       std::vector<Value> values(output_schema_->GetColumnCount());
       auto &output_columns = output_schema_->GetColumns();
       for (uint32_t i = 0; i < values.size(); ++i) {
-        values[i] =
-            output_columns[i].GetExpr()->EvaluateJoin(tuple, outer_table_schema_, &inner_tuple, inner_table_schema_);
+        values[i] = output_columns[i].GetExpr()->EvaluateJoin(outer_tuple, outer_table_schema_, inner_tuple,
+                                                              inner_table_schema_);
       }
 
       *tuple = Tuple(values, output_schema_);
       return true;
     }
   }
-
-  return false;
 }
 
 }  // namespace bustub
@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class BufferPoolManagerInstance;
+
+/**
+ * BufferAccessStrategy keeps a bulk operation such as a sequential scan from flushing the buffer pool.
+ *
+ * Pages fetched through a strategy are loaded into a small private ring of frames. Once the ring is full, the next miss
+ * reuses the frame the strategy filled ring_size misses ago, as long as nobody else has pinned or replaced the page in
+ * it since. The rest of the pool keeps its working set no matter how many pages the bulk operation touches.
+ *
+ * Every scan or insert uses its own strategy. The ring of an instance is only touched under that instance's latch, so
+ * the background prefetcher may load pages into the rings of a strategy while its scan is running.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size the number of frames the strategy may cycle through in each buffer pool instance, at most
+   */
+  explicit BufferAccessStrategy(size_t ring_size = BUFFER_ACCESS_STRATEGY_RING_SIZE) : ring_size_(ring_size) {}
+
+  /** @return the largest number of frames in the ring of a buffer pool instance */
+  size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  /** A frame the strategy loaded a page into. */
+  struct RingSlot {
+    frame_id_t frame_id_;
+    /** The page the strategy loaded, if the frame holds a different one now it was replaced by someone else. */
+    page_id_t page_id_;
+  };
+
+  /** The ring of one buffer pool instance. */
+  struct Ring {
+    std::vector<RingSlot> slots_;
+    /** The slot to reuse next once the ring is full. */
+    size_t next_{0};
+    /** How many slots the ring has in this instance. */
+    size_t capacity_{0};
+  };
+
+  /**
+   * @param bpm the buffer pool instance asking
+   * @param pool_size the number of frames of that instance
+   * @return the ring of the instance, created on first use. A ring never takes more than an eighth of the frames of
+   * an instance, so a scan cannot flush a small pool through its ring either.
+   */
+  Ring &GetRing(const BufferPoolManager *bpm, size_t pool_size) {
+    std::lock_guard<std::mutex> guard(rings_latch_);
+    auto [iter, inserted] = rings_.try_emplace(bpm);
+    if (inserted) {
+      iter->second.capacity_ = std::min(ring_size_, std::max<size_t>(pool_size / 8, 2));
+    }
+    return iter->second;
+  }
+
+  /**
+   * @param bpm the buffer pool instance asking
+   * @param pool_size the number of frames of that instance
+   * @return the ring slot up for reuse, nullptr while the ring is not full yet
+   */
+  const RingSlot *NextSlot(const BufferPoolManager *bpm, size_t pool_size) {
+    Ring &ring = GetRing(bpm, pool_size);
+    return ring.slots_.size() < ring.capacity_ ? nullptr : &ring.slots_[ring.next_];
+  }
+
+  /**
+   * Put a frame that was just loaded on behalf of this strategy into the ring, in place of the slot NextSlot returned.
+   * @param bpm the buffer pool instance that loaded the frame
+   * @param pool_size the number of frames of that instance
+   * @param frame_id the loaded frame
+   * @param page_id the page loaded into the frame
+   */
+  void Remember(const BufferPoolManager *bpm, size_t pool_size, frame_id_t frame_id, page_id_t page_id) {
+    Ring &ring = GetRing(bpm, pool_size);
+    if (ring.slots_.size() < ring.capacity_) {
+      ring.slots_.push_back({frame_id, page_id});
+      ring.next_ = ring.slots_.size() % ring.capacity_;
+      return;
+    }
+    ring.slots_[ring.next_] = {frame_id, page_id};
+    ring.next_ = (ring.next_ + 1) % ring.capacity_;
+  }
+
+  size_t ring_size_;
+  /** One ring per buffer pool instance, frame ids are only meaningful within their instance. */
+  std::unordered_map<const BufferPoolManager *, Ring> rings_;
+  /** Protects the structure of rings_, the rings themselves are protected by the latch of their instance. */
+  std::mutex rings_latch_;
+};
+
+}  // namespace bustub
@@ -12,37 +12,70 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
-#include "recovery/log_manager.h"
-#include "storage/disk/disk_manager.h"
+#include "buffer/buffer_access_strategy.h"
+#include "common/config.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
+/** Counters of the background writer of a buffer pool. */
+struct BackgroundWriterStats {
+  /** Dirty pages the background writer wrote back and could mark clean. */
+  size_t pages_cleaned_{0};
+  /** Evictions that still had to write a dirty victim in the thread that needed the frame. */
+  size_t foreground_writes_{0};
+};
+
+/** Counters of a buffer pool. GetStats takes a snapshot of them, ResetStats starts them over. */
+struct BufferPoolStats {
+  /** Number of buckets of the miss latency histogram. */
+  static constexpr size_t NUM_LATENCY_BUCKETS = 16;
+
+  /** Fetches that found the page in the pool. */
+  size_t hits_{0};
+  /** Fetches that had to read the page from disk, including the reads of the prefetcher. */
+  size_t misses_{0};
+  /** Pages that were pushed out of the pool to make room for another page. */
+  size_t evictions_{0};
+  /** Pages written back to disk, by evictions, flushes, deletes and the background writer. */
+  size_t dirty_writes_{0};
+  /** Write backs that had to wait for the log to be flushed up to the LSN of the page first. */
+  size_t log_forces_{0};
+  /** Misses that found the page in the compressed page cache instead of reading it from disk. */
+  size_t compressed_hits_{0};
+  /** Total time threads spent waiting for the latch of the pool, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+  /** Bucket i counts the misses that took less than 2^i microseconds. The last bucket also counts all slower ones. */
+  std::array<size_t, NUM_LATENCY_BUCKETS> miss_latency_histogram_{};
+
+  /** @return the fraction of fetches that were hits, 0 if there were no fetches */
+  double HitRatio() const {
+    return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(hits_ + misses_);
+  }
+};
+
 /**
- * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ * BufferPoolManager is the interface shared by every buffer pool implementation. Callers such as TableHeap, BPlusTree
+ * and the executors only ever talk to a BufferPoolManager, so a single instance and a sharded pool are interchangeable.
  */
 class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
 
-  /**
-   * Creates a new BufferPoolManager.
-   * @param pool_size the size of the buffer pool
-   * @param disk_manager the disk manager
-   * @param log_manager the log manager (for testing only: nullptr = disable logging)
-   */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager() = default;
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager() = default;
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -91,11 +124,127 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
-  /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() { return pages_; }
+  /**
+   * Fetch a page on behalf of a bulk operation, so that a miss recycles the strategy's ring of frames instead of
+   * evicting the working set of the pool.
+   * @param page_id id of page to be fetched
+   * @param strategy the strategy of the bulk operation, nullptr to fetch like FetchPage
+   * @return the requested page, nullptr if it could not be fetched
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) { return FetchPageImpl(page_id, strategy); }
+
+  /**
+   * Fetch a batch of pages with one pass over the buffer pool. The pages that miss are read together once a frame is
+   * claimed for every one of them, instead of one miss after the other.
+   * @param page_ids ids of the pages to be fetched, a page that appears twice is pinned twice
+   * @return the pages in the order of page_ids, nullptr for a page that could not be fetched. Every other entry has to
+   * be unpinned.
+   */
+  std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids) {
+    std::vector<Page *> pages(page_ids.size());
+    FetchPagesImpl(page_ids, &pages);
+    return pages;
+  }
+
+  /**
+   * Fetch a page and guard its pin, the guard unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the strategy of the bulk operation the fetch is for, may be nullptr
+   * @return the guard, empty if the page could not be fetched
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    return BasicPageGuard(this, FetchPageImpl(page_id, strategy));
+  }
+
+  /**
+   * Fetch a page and latch it for reading, the guard unlatches and unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the strategy of the bulk operation the fetch is for, may be nullptr
+   * @return the guard, empty if the page could not be fetched
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    return FetchPageBasic(page_id, strategy).UpgradeRead();
+  }
+
+  /**
+   * Fetch a page and latch it for writing, the guard unlatches and unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the strategy of the bulk operation the fetch is for, may be nullptr
+   * @return the guard, empty if the page could not be fetched
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    return FetchPageBasic(page_id, strategy).UpgradeWrite();
+  }
+
+  /**
+   * Create a new page and guard its pin.
+   * @param[out] page_id id of created page
+   * @return the guard, empty if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id) { return BasicPageGuard(this, NewPageImpl(page_id)); }
+
+  /**
+   * Ask the buffer pool to read a page in the background, so that a later FetchPage finds it resident. The page is
+   * not pinned and may be evicted again before anyone fetches it. Prefetching is a hint, it may be dropped.
+   * @param page_id id of page to be prefetched
+   * @param strategy the strategy of the scan the prefetch is for, the page is loaded into its ring
+   */
+  void PrefetchPage(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy = nullptr) {
+    PrefetchPageImpl(page_id, strategy);
+  }
+
+  /**
+   * Prefetch the pages [first_page_id, first_page_id + num_pages).
+   * @param first_page_id id of the first page to be prefetched
+   * @param num_pages number of pages to be prefetched
+   * @param strategy the strategy of the scan the prefetch is for, the pages are loaded into its ring
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t num_pages,
+                     const std::shared_ptr<BufferAccessStrategy> &strategy = nullptr) {
+    for (size_t i = 0; i < num_pages; i++) {
+      PrefetchPageImpl(first_page_id + static_cast<page_id_t>(i), strategy);
+    }
+  }
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() { return pool_size_; }
+  virtual size_t GetPoolSize() = 0;
+
+  /**
+   * Change the number of frames of the buffer pool while it is in use. Growing adds free frames right away. Shrinking
+   * evicts the pages in the frames that go away, writing the dirty ones back, and waits until the pinned ones among
+   * them are unpinned. Pages that stay pinned while the pool shrinks keep their frame until then.
+   * @param pool_size the new size of the buffer pool
+   * @return false if pool_size is zero or beyond the size the pool was created to grow to, true otherwise
+   */
+  virtual bool Resize(size_t pool_size) = 0;
+
+  /**
+   * Start a background thread that writes dirty, unpinned pages back ahead of eviction. Whenever fewer than
+   * low_watermark frames are clean and evictable, it cleans frames until high_watermark of them are. Evictions then
+   * rarely have to write a dirty victim in the thread that asked for the frame.
+   * @param low_watermark the number of clean frames below which the writer starts cleaning
+   * @param high_watermark the number of clean frames the writer cleans up to
+   */
+  virtual void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) = 0;
+
+  /** Stop the background writer, if it is running. */
+  virtual void StopBackgroundWriter() = 0;
+
+  /** @return the counters of the background writer */
+  virtual BackgroundWriterStats GetBackgroundWriterStats() = 0;
+
+  /** @return a snapshot of the counters of the buffer pool */
+  virtual BufferPoolStats GetStats() = 0;
+
+  /** Reset the counters of the buffer pool to zero. */
+  virtual void ResetStats() = 0;
+
+  /**
+   * Take a snapshot of the dirty pages for a fuzzy checkpoint, without waiting for any I/O or pinned page.
+   * @return the recLSN of every page that may differ from disk: each change to the page that is not on disk yet was
+   * logged at or after it
+   */
+  virtual std::unordered_map<page_id_t, lsn_t> GetDirtyPageTable() = 0;
 
  protected:
   /**
@@ -116,7 +265,34 @@ class BufferPoolManager {
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id) = 0;
+
+  /**
+   * Fetch the requested page from the buffer pool on behalf of a BufferAccessStrategy.
+   * Buffer pools without rings simply ignore the strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the strategy whose ring a miss should reuse, may be nullptr
+   * @return the requested page
+   */
+  virtual Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) { return FetchPageImpl(page_id); }
+
+  /**
+   * Fetch a batch of pages. Buffer pools that cannot batch fetch the pages one at a time.
+   * @param page_ids ids of the pages to be fetched
+   * @param[out] pages the fetched pages, one per page id, nullptr for a page that could not be fetched
+   */
+  virtual void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) {
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      (*pages)[i] = FetchPageImpl(page_ids[i]);
+    }
+  }
+
+  /**
+   * Queue a page to be read in the background. Buffer pools that cannot prefetch ignore the request.
+   * @param page_id id of page to be prefetched
+   * @param strategy the strategy whose ring the page should be loaded into, may be nullptr
+   */
+  virtual void PrefetchPageImpl(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy) {}
 
   /**
    * Unpin the target page from the buffer pool.
@@ -124,49 +300,32 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty) = 0;
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id) = 0;
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id) = 0;
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id) = 0;
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl();
-
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
-  /** Array of buffer pool pages. */
-  Page *pages_;
-  /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
-  /** List of free pages. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
+  virtual void FlushAllPagesImpl() = 0;
 };
 }  // namespace bustub
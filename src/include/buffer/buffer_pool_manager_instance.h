@@ -0,0 +1,473 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_instance.h
+//
+// Identification: src/include/buffer/buffer_pool_manager_instance.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <new>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** Replacement policy a buffer pool uses to pick victim frames. */
+enum class ReplacerPolicy {
+  /** Least recently unpinned frame, see LRUReplacer. */
+  LRU,
+  /** Largest backward K-distance, see LRUKReplacer. Resistant to sequential scans. */
+  LRU_K,
+  /** Second chance clock, see ClockReplacer. Pin and Unpin take no lock. */
+  CLOCK,
+};
+
+/**
+ * BufferPoolManagerInstance reads disk pages to and from its internal buffer pool.
+ *
+ * The latch is never held across disk I/O. A frame that is being written back or read in is marked with a FrameState,
+ * and threads that want a page in such a frame wait on the frame's condition variable instead of the latch.
+ *
+ * The frames are reserved for max_pool_size pages up front and never move, so Resize can change the number of frames
+ * in use while pages are pinned. Frames at or beyond pool_size_ are retired: they are neither on the free list nor in
+ * the replacer. The frames in use are registered with the disk manager, see DiskManager::RegisterBuffers.
+ */
+class BufferPoolManagerInstance : public BufferPoolManager {
+  // Flushes all instances as one batch per round, with the flush steps of every instance.
+  friend class ParallelBufferPoolManager;
+
+ public:
+  /**
+   * Creates a new BufferPoolManagerInstance.
+   * @param pool_size the size of the buffer pool
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy used to pick victim frames
+   * @param max_pool_size the size the buffer pool can be grown to, 0 = pool_size
+   * @param compressed_cache_size bytes of the compressed page cache behind the pool, 0 = no compressed page cache
+   */
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU, size_t max_pool_size = 0,
+                            size_t compressed_cache_size = 0);
+
+  /**
+   * Creates a new BufferPoolManagerInstance that is one shard of a parallel buffer pool.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of instances in the parallel buffer pool
+   * @param instance_index index of this instance within the parallel buffer pool
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy used to pick victim frames
+   * @param max_pool_size the size the buffer pool can be grown to, 0 = pool_size
+   * @param compressed_cache_size bytes of the compressed page cache behind the pool, 0 = no compressed page cache
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU, size_t max_pool_size = 0,
+                            size_t compressed_cache_size = 0);
+
+  /**
+   * Destroys an existing BufferPoolManagerInstance.
+   */
+  ~BufferPoolManagerInstance() override;
+
+  /** @return pointer to all the pages in the buffer pool */
+  Page *GetPages() { return pages_; }
+
+  /** @return size of the buffer pool */
+  size_t GetPoolSize() override { return pool_size_; }
+
+  /** @return the compressed page cache behind the pool, nullptr if there is none */
+  CompressedPageCache *GetCompressedPageCache() { return page_cache_.get(); }
+
+  /** @return the size the buffer pool can be grown to */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  bool Resize(size_t pool_size) override;
+
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  BackgroundWriterStats GetBackgroundWriterStats() override;
+
+  BufferPoolStats GetStats() override;
+
+  void ResetStats() override;
+
+  std::unordered_map<page_id_t, lsn_t> GetDirtyPageTable() override;
+
+ protected:
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Pin the resident pages and claim frames for the missing ones under one latch acquisition, then write back the
+   * dirty victims and read the missing pages as one batch without the latch.
+   */
+  void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) override;
+
+  /**
+   * Queue a page for the prefetch thread of this instance, which is started on the first request. Requests beyond
+   * pool_size_ outstanding ones are dropped.
+   */
+  void PrefetchPageImpl(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy) override;
+
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  void FlushAllPagesImpl() override;
+
+  /**
+   * Allocate a page id that belongs to this instance, i.e. page_id % num_instances_ == instance_index_, from the disk
+   * manager, which hands out deallocated page ids again. Page ids never collide across instances. Must be called with
+   * latch_ held.
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage();
+
+  /**
+   * Check that a page id handed to this instance actually belongs to it.
+   * @param page_id the page id to check
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /** State of a frame with respect to in-flight disk I/O. */
+  enum class FrameState {
+    /** The frame is on the free list. */
+    FREE,
+    /** The frame is being filled from disk, its page is not readable yet. */
+    LOADING,
+    /** The frame holds its page and can be handed out. */
+    RESIDENT,
+    /** The frame still holds a dirty victim that is being written back before the frame is reused. */
+    EVICTING,
+  };
+
+  /**
+   * Look up a page in the page table and wait until its frame is resident. Must be called with the latch held, the
+   * latch is released while waiting.
+   * @param lock the held latch
+   * @param page_id id of the page to look up
+   * @param[out] frame_id the frame that holds the page
+   * @return false if the page is not in the buffer pool
+   */
+  bool FindResidentFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t *frame_id);
+
+  /**
+   * Pick a frame to reuse, from the free list first and from the replacer otherwise. Must be called with the latch
+   * held. If a strategy is given and its ring is full, the ring frame up for reuse is taken instead, provided it still
+   * holds the page the strategy loaded into it and is not pinned.
+   * @param[out] frame_id the picked frame
+   * @param strategy the strategy of the caller, may be nullptr
+   * @return false if every frame is pinned
+   */
+  bool FindVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Take a victim from the replacer. With logging on, a dirty victim whose page LSN is not persistent yet would have to
+   * force the log before it can be written back, so up to VICTIM_CANDIDATES victims are looked at for one that does
+   * not. If there is none, the one with the lowest page LSN is taken. The others go back to the replacer. Must be
+   * called with the latch held.
+   * @param[out] frame_id the picked frame
+   * @return false if every frame is pinned
+   */
+  bool PickReplacerVictim(frame_id_t *frame_id);
+
+  /** @return true if the frame holds a dirty page that cannot be written back before the log is flushed further */
+  bool NeedsLogForce(frame_id_t frame_id, lsn_t persistent_lsn) const;
+
+  /**
+   * Write-ahead logging: flush the log up to the given lsn, if logging is on and it is not persistent yet. Must be
+   * called without the latch, it waits for the log to be written.
+   * @param lsn the highest page LSN about to be written
+   */
+  void ForceLog(lsn_t lsn);
+
+  /** @return the LSN stored in the header of the given page data */
+  static lsn_t PageLSN(const char *data);
+
+  /**
+   * Start the recLSN of a frame if its page was just pinned while clean: any change made under this pin is logged
+   * at or after the next lsn. Must be called with the latch held, after the pin.
+   * @param frame_id the frame that was pinned
+   */
+  void TrackRecLSN(frame_id_t frame_id);
+
+  /**
+   * FetchPagesImpl for a caller with a buffer access strategy, which then picks the frames of the missing pages.
+   * @param page_ids the pages to fetch
+   * @param[out] pages the fetched pages, one per page id, nullptr where no frame was left
+   * @param strategy the strategy of the caller, may be nullptr
+   */
+  void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages,
+                      BufferAccessStrategy *strategy);
+
+  /**
+   * Point a frame at a new page and pin it. Must be called with the latch held. The frame is left LOADING, or
+   * EVICTING if its old page is dirty or goes to the compressed page cache, in which case the caller has to call
+   * EvictVictim.
+   * @param frame_id the frame to reuse
+   * @param page_id the page that is going to live in the frame
+   * @param[out] victim_dirty whether the old page has to be written back
+   * @return the id of the page that has to be evicted, INVALID_PAGE_ID if there is none
+   */
+  page_id_t AssignFrame(frame_id_t frame_id, page_id_t page_id, bool *victim_dirty);
+
+  /**
+   * Evict the old page of a frame that AssignFrame left EVICTING, without the latch: write it back if it is dirty, put
+   * it into the compressed page cache if there is one, then call FinishEviction.
+   * @param frame_id the frame that holds the victim
+   * @param victim_page_id the page to evict
+   * @param victim_dirty whether the page has to be written back
+   */
+  void EvictVictim(frame_id_t frame_id, page_id_t victim_page_id, bool victim_dirty);
+
+  /**
+   * Read a page into a frame, from the compressed page cache if it has the page and from disk otherwise.
+   * @param page_id the page to read
+   * @param[out] data the data of the frame
+   */
+  void ReadIn(page_id_t page_id, char *data);
+
+  /**
+   * Take a page out of the compressed page cache into a frame, and count the hit.
+   * @param page_id the page to read
+   * @param[out] data the data of the frame
+   * @return false if there is no compressed page cache or it does not have the page
+   */
+  bool ReadInFromCache(page_id_t page_id, char *data);
+
+  /**
+   * Body of the prefetch thread. Loads queued pages that are not in the page table yet, a batch at a time, and leaves
+   * them unpinned.
+   */
+  void RunPrefetcher();
+
+  /**
+   * Body of the background writer thread. Every bgwriter_interval, or when woken up by a foreground write, it calls
+   * CleanFrames.
+   */
+  void RunBackgroundWriter();
+
+  /**
+   * Write back dirty unpinned pages until high watermark frames are clean, if fewer than low watermark are. A few pages
+   * at a time are pinned and copied under the latch and written as one batch without it. A page is only marked clean
+   * afterwards if nobody else pinned or changed it in the meantime.
+   */
+  void CleanFrames();
+
+  /** @return a lock on latch_. Time spent waiting for it is added to the latch wait counter. */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /**
+   * Lock a lock on latch_ again after it was released, and count the time spent waiting like LockLatch.
+   * @param lock the released lock
+   */
+  void RelockLatch(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Write a page out of a frame to disk and count the write. The log is flushed up to the page LSN first.
+   * @param page_id the page to write
+   * @param data the content to write
+   */
+  void WriteBack(page_id_t page_id, const char *data);
+
+  /** Deletes the page copies AllocatePageCopies hands out. */
+  struct PageCopiesDeleter {
+    void operator()(char *data) const { ::operator delete[](data, std::align_val_t{PAGE_SIZE}); }
+  };
+  using PageCopies = std::unique_ptr<char[], PageCopiesDeleter>;
+
+  /**
+   * Allocate room to stage page copies for a batched write. It is aligned like the frames, so that a disk manager
+   * doing direct I/O writes the copies as they are instead of through bounce buffers.
+   * @param num_pages the number of pages there is room for
+   */
+  static PageCopies AllocatePageCopies(size_t num_pages);
+
+  /** A batch of pages FlushAllPages writes back together. The pages stay pinned until FinishFlush. */
+  struct FlushBatch {
+    std::vector<frame_id_t> frame_ids_;
+    std::vector<page_id_t> page_ids_;
+    /** The copies of the pages, which are written instead of the frames. */
+    std::vector<const char *> data_;
+  };
+
+  /**
+   * @return the resident pages that may differ from disk with their frames, sorted by page id: the dirty ones, and the
+   * pinned ones, whose holders may have changed them without telling yet
+   */
+  std::vector<std::pair<page_id_t, frame_id_t>> CollectPagesToFlush();
+
+  /**
+   * Pin the collected pages that are still in their frames, copy them and add them to a batch.
+   * @param begin the first of the pages collected by CollectPagesToFlush
+   * @param end one past the last of the pages
+   * @param copies where the copies go, with room for all of the pages
+   * @param[out] batch the batch the pages are added to
+   */
+  void PinPagesToFlush(std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator begin,
+                       std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator end, char *copies,
+                       FlushBatch *batch);
+
+  /**
+   * Count the writes of a batch that was written back, unpin its pages and mark them clean, unless someone else holds
+   * them or changed them meanwhile.
+   * @param batch the written batch
+   */
+  void FinishFlush(const FlushBatch &batch);
+
+  /**
+   * Write a batch of pages to disk. The log is flushed up to the highest page LSN first.
+   * @param page_ids the pages to write
+   * @param data the content to write, one entry per page
+   */
+  void WriteBackPages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &data);
+
+  /**
+   * Count a miss and the time it took in the miss latency histogram.
+   * @param start when the miss was detected
+   */
+  void RecordMiss(std::chrono::steady_clock::time_point start);
+
+  /**
+   * Make a frame whose pin count dropped to zero evictable. A retired frame is not handed to the replacer, instead
+   * Resize is told that one more of the frames it waits for is unpinned. Must be called with the latch held.
+   * @param frame_id the unpinned frame
+   */
+  void UnpinFrame(frame_id_t frame_id);
+
+  /**
+   * Retire the frames from pool_size down to the current size. Waits until every page in them is unpinned, writes the
+   * dirty ones back and releases their memory.
+   * @param pool_size the new size of the buffer pool
+   */
+  void Shrink(size_t pool_size);
+
+  /** Wake up the background writer, a foreground thread just had to write a dirty victim. */
+  void WakeBackgroundWriter();
+
+  /**
+   * Remove a written back victim from the page table and move its frame on to LOADING. Takes the latch.
+   * @param frame_id the frame that held the victim
+   * @param victim_page_id the page that was written back
+   */
+  void FinishEviction(frame_id_t frame_id, page_id_t victim_page_id);
+
+  /** Number of frames in use, frames [pool_size_, max_pool_size_) are retired. Only changed under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames reserved, the buffer pool cannot grow beyond it. */
+  const size_t max_pool_size_;
+  /** How many instances are in the parallel buffer pool (1 if this instance stands alone). */
+  const uint32_t num_instances_ = 1;
+  /** Index of this instance in the parallel buffer pool (0 if this instance stands alone). */
+  const uint32_t instance_index_ = 0;
+  /** Data of every reserved frame, pages_[i] points to frame i. */
+  FrameArena arena_;
+  /** Array of buffer pool pages, each aligned to a cache line. */
+  Page *pages_;
+  /** I/O state of every frame, protected by latch_. */
+  FrameState *frame_states_;
+  /** Signalled whenever the frame with the same index leaves LOADING or EVICTING. */
+  std::condition_variable *frame_cvs_;
+  /** The recLSN of the page in every frame, meaningful while the page is dirty. Protected by latch_. */
+  lsn_t *rec_lsns_;
+  /** The recLSN of every dirty victim between AssignFrame and FinishEviction, its frame already holds the new page. */
+  std::unordered_map<page_id_t, lsn_t> evicting_rec_lsns_;
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_ __attribute__((__unused__));
+  /** True if the disk manager took the frames in use as registered buffers, which have to be unregistered. */
+  bool frames_registered_{false};
+  /** Pointer to the log manager. */
+  LogManager *log_manager_;
+  /** Second tier that keeps evicted pages compressed, nullptr if disabled. */
+  std::unique_ptr<CompressedPageCache> page_cache_;
+  /** Page table for keeping track of buffer pool pages. */
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Replacer to find unpinned pages for replacement. */
+  Replacer *replacer_;
+  /** List of free pages. */
+  std::list<frame_id_t> free_list_;
+  /** This latch protects page_table_, free_list_, frame_states_ and the metadata of every page in pages_. */
+  std::mutex latch_;
+  /** Serializes calls to Resize. Never taken while holding latch_. */
+  std::mutex resize_latch_;
+  /** Signalled whenever a retired frame is unpinned or freed, a shrinking Resize waits on it with latch_. */
+  std::condition_variable resize_cv_;
+
+  /** Background thread serving prefetch_queue_, started lazily. */
+  std::thread prefetch_thread_;
+  /** Pages waiting to be prefetched, with the strategy of the scan that asked for them. */
+  std::deque<std::pair<page_id_t, std::shared_ptr<BufferAccessStrategy>>> prefetch_queue_;
+  /** Set when the instance is destroyed, tells the prefetch thread to exit. */
+  bool stop_prefetching_{false};
+  /** Protects prefetch_thread_, prefetch_queue_ and stop_prefetching_. Never taken while holding latch_. */
+  std::mutex prefetch_latch_;
+  /** Signalled when a prefetch is queued or stop_prefetching_ is set. */
+  std::condition_variable prefetch_cv_;
+
+  /** The background writer thread, if started. */
+  std::thread bgwriter_thread_;
+  /** Clean frames below which the background writer starts cleaning. */
+  size_t bgwriter_low_watermark_{0};
+  /** Clean frames up to which the background writer cleans. */
+  size_t bgwriter_high_watermark_{0};
+  /** The frame the background writer looks at next, it sweeps the frames round robin. Protected by latch_. */
+  size_t bgwriter_cursor_{0};
+  /** Set to tell the background writer to exit. */
+  bool stop_bgwriter_{false};
+  /** Set to make the background writer run a round right away. */
+  bool bgwriter_wakeup_{false};
+  /** Protects bgwriter_thread_, the watermarks, stop_bgwriter_ and bgwriter_wakeup_. Never taken before latch_. */
+  std::mutex bgwriter_latch_;
+  /** Signalled when stop_bgwriter_ or bgwriter_wakeup_ is set. */
+  std::condition_variable bgwriter_cv_;
+  /** Pages the background writer cleaned. */
+  std::atomic<size_t> num_pages_cleaned_{0};
+  /** Dirty victims written back by the thread that needed the frame. */
+  std::atomic<size_t> num_foreground_writes_{0};
+
+  /** Counters behind GetStats, see BufferPoolStats. They are only ever updated with relaxed atomics. */
+  std::atomic<size_t> num_hits_{0};
+  std::atomic<size_t> num_misses_{0};
+  std::atomic<size_t> num_evictions_{0};
+  std::atomic<size_t> num_dirty_writes_{0};
+  std::atomic<size_t> num_log_forces_{0};
+  std::atomic<size_t> num_compressed_hits_{0};
+  std::atomic<uint64_t> latch_wait_ns_{0};
+  std::array<std::atomic<size_t>, BufferPoolStats::NUM_LATENCY_BUCKETS> miss_latency_histogram_{};
+};
+}  // namespace bustub
@@ -12,8 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +23,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The replacer takes no lock. Every frame has an atomic state word with an evictable bit and a reference bit. Pin and
+ * Unpin flip those bits with a single atomic instruction, and Victim advances an atomic clock hand and claims a frame
+ * by compare-and-swapping its state from evictable to nothing.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,10 +47,23 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void PutBack(frame_id_t frame_id) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** The frame is unpinned and sits in the clock. */
+  static constexpr uint8_t EVICTABLE = 0x1;
+  /** The frame was used since the clock hand last passed it. */
+  static constexpr uint8_t REFERENCED = 0x2;
+
+  size_t num_pages_;
+  /** State word of every frame, indexed by frame id. */
+  std::vector<std::atomic<uint8_t>> frame_states_;
+  /** Total number of steps the clock hand has taken, the hand points at clock_hand_ % num_pages_. */
+  std::atomic<size_t> clock_hand_{0};
+  /** Number of evictable frames. Signed, a racing Victim may claim a frame before Unpin has counted it. */
+  std::atomic<int64_t> size_{0};
 };
 
 }  // namespace bustub
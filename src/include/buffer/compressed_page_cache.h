@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a second tier below a buffer pool. It keeps pages that were evicted from the pool compressed
+ * in memory, within a budget of bytes, and drops the least recently inserted ones when the budget is exceeded. A fetch
+ * that misses the pool looks here before it reads from disk.
+ *
+ * The cache is exclusive: a page taken out of it is removed, so a page is never in the pool and in the cache at the
+ * same time, and the copy in the cache is always the one on disk.
+ *
+ * Pages are compressed with a byte oriented LZ77 scheme in the style of LZ4: a sequence of literals followed by a
+ * back reference into the page. Runs of zeros and repeated row layouts shrink to a few bytes each.
+ */
+class CompressedPageCache {
+ public:
+  /**
+   * Create a new CompressedPageCache.
+   * @param budget the number of bytes the compressed pages may take up
+   */
+  explicit CompressedPageCache(size_t budget);
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * Compress a page and keep it, replacing an older copy of the same page. A page that does not compress to less than
+   * PAGE_SIZE is not kept.
+   * @param page_id id of the page
+   * @param data the PAGE_SIZE bytes of the page
+   */
+  void Insert(page_id_t page_id, const char *data);
+
+  /**
+   * Take a page out of the cache.
+   * @param page_id id of the page
+   * @param[out] data PAGE_SIZE bytes that receive the page
+   * @return false if the page is not in the cache
+   */
+  bool Take(page_id_t page_id, char *data);
+
+  /**
+   * Drop a page from the cache, if it is there.
+   * @param page_id id of the page
+   */
+  void Erase(page_id_t page_id);
+
+  /** @return the number of pages in the cache */
+  size_t GetNumPages();
+
+  /** @return the number of bytes the compressed pages take up */
+  size_t GetSize();
+
+  /**
+   * Compress a page.
+   * @param data the PAGE_SIZE bytes of the page
+   * @param[out] compressed the compressed page
+   * @return false if the page does not compress to less than PAGE_SIZE
+   */
+  static bool Compress(const char *data, std::vector<char> *compressed);
+
+  /**
+   * Decompress a page.
+   * @param compressed the compressed page
+   * @param[out] data PAGE_SIZE bytes that receive the page
+   * @return false if compressed is not a valid compressed page
+   */
+  static bool Decompress(const std::vector<char> &compressed, char *data);
+
+ private:
+  struct Entry {
+    /** Position of the page in lru_list_. */
+    std::list<page_id_t>::iterator lru_iter_;
+    /** The compressed page. */
+    std::vector<char> data_;
+  };
+
+  /** Remove a page, the latch must be held. @return the compressed page */
+  std::vector<char> EraseEntry(std::unordered_map<page_id_t, Entry>::iterator iter);
+
+  /** The number of bytes the compressed pages may take up. */
+  const size_t budget_;
+  /** The number of bytes the compressed pages take up. */
+  size_t size_{0};
+  /** Pages in the order they were inserted, the oldest at the front. */
+  std::list<page_id_t> lru_list_;
+  /** The compressed pages. */
+  std::unordered_map<page_id_t, Entry> entries_;
+  /** Protects everything above. Compression runs outside of it. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is one contiguous allocation that holds the data of every frame of a buffer pool. Every frame is
+ * PAGE_SIZE aligned, which direct I/O requires. An arena of at least HUGE_PAGE_SIZE is aligned to and backed by huge
+ * pages where the system has them, so a large pool needs far fewer TLB entries.
+ *
+ * The arena is reserved up front but only takes memory once a frame is first touched, so a pool can be created with
+ * room to grow into. Release hands the memory of frames that are no longer used back to the system.
+ */
+class FrameArena {
+ public:
+  /**
+   * Reserve the arena. Every frame reads as zeros until it is written.
+   * @param num_frames the number of frames the arena holds
+   */
+  explicit FrameArena(size_t num_frames);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of the given frame */
+  char *GetFrame(frame_id_t frame_id) { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Give the memory of a range of frames back to the system. The frames stay usable and read as zeros again. This is a
+   * no-op for an arena on reserved huge pages, which are not returned piecemeal.
+   * @param first_frame_id the first frame of the range
+   * @param num_frames the number of frames in the range
+   */
+  void Release(frame_id_t first_frame_id, size_t num_frames);
+
+  /** @return true if the arena is mapped from the reserved huge pages of the system, not transparent huge pages */
+  bool IsHugeTlb() const { return is_huge_tlb_; }
+
+ private:
+  /** Size of the allocation in bytes, the frames rounded up to a whole number of huge pages for large arenas. */
+  size_t size_;
+  /** Start of the first frame. */
+  char *data_;
+  /** True if data_ was mmap'ed with MAP_HUGETLB. */
+  bool is_huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward K-distance of a frame is the time between now and its K-th most recent access. The victim is the
+ * evictable frame with the largest backward K-distance. Frames with fewer than K recorded accesses have an infinite
+ * K-distance and go first, oldest first access first. A page that a sequential scan touches only once therefore never
+ * pushes out a page that is accessed over and over.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses remembered per frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void PutBack(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** Access history of one frame. */
+  struct FrameEntry {
+    /** Timestamps of the last (at most) k accesses, oldest first. */
+    std::list<size_t> history_;
+    /** Whether the frame is unpinned and may be victimized. */
+    bool evictable_{false};
+  };
+
+  size_t max_capacity_;
+  size_t k_;
+  /** Logical clock, bumped on every recorded access. */
+  size_t current_timestamp_{0};
+  /** Number of evictable frames. */
+  size_t curr_size_{0};
+  std::unordered_map<frame_id_t, FrameEntry> frames_;
+  /** Access history of the frames Victim returned, for PutBack. A frame's next Victim overwrites it. */
+  std::unordered_map<frame_id_t, std::list<size_t>> victims_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -43,6 +43,8 @@ class LRUReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void PutBack(frame_id_t frame_id) override;
+
   size_t Size() override;
 
  private:
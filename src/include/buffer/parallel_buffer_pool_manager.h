@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool across several independent BufferPoolManagerInstances, each with
+ * its own latch, page table and replacer. A page always lives in the instance page_id % num_instances, so threads
+ * working on different pages rarely contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy of every instance
+   * @param max_pool_size the size each instance can be grown to, 0 = pool_size
+   * @param compressed_cache_size bytes of the compressed page cache of each instance, 0 = no compressed page cache
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::LRU,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return size of the buffer pool, summed over all instances */
+  size_t GetPoolSize() override;
+
+  /**
+   * Resize every instance. The size is for the whole pool and is split evenly between the instances, rounding up.
+   * @param pool_size the new size of the buffer pool
+   * @return false if an instance cannot grow that far
+   */
+  bool Resize(size_t pool_size) override;
+
+  /**
+   * Start the background writer of every instance. The watermarks are for the whole pool and are split evenly
+   * between the instances.
+   * @param low_watermark the number of clean frames below which the writers start cleaning
+   * @param high_watermark the number of clean frames the writers clean up to
+   */
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  /** @return the counters of the background writers, summed over all instances */
+  BackgroundWriterStats GetBackgroundWriterStats() override;
+
+  /** @return the counters of the buffer pool, summed over all instances */
+  BufferPoolStats GetStats() override;
+
+  void ResetStats() override;
+
+  std::unordered_map<page_id_t, lsn_t> GetDirtyPageTable() override;
+
+  /** @return the number of instances the pool is sharded into */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+ protected:
+  /**
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling the given page id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  Page *FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /** Split the batch by instance and let every instance fetch its share as one batch. */
+  void FetchPagesImpl(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) override;
+
+  void PrefetchPageImpl(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy) override;
+
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page. Instances are tried round robin, starting one past the instance that served the previous
+   * request, so new pages spread evenly across the shards.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  void FlushAllPagesImpl() override;
+
+ private:
+  /** The shards of this buffer pool, instance i owns every page with page_id % num_instances == i. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** The instance NewPageImpl tries first. */
+  size_t start_index_{0};
+  /** Protects start_index_. */
+  std::mutex latch_;
+};
+}  // namespace bustub
@@ -43,6 +43,26 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Puts back a frame that Victim just returned, without counting it as used: it keeps the place it had before Victim
+   * took it, as far as the policy can tell. Frames put back in the reverse order Victim returned them end up in their
+   * old order.
+   * @param frame_id the id of the frame to put back
+   */
+  virtual void PutBack(frame_id_t frame_id) = 0;
+
+  /**
+   * Records that the page in a frame was accessed. Policies that only look at unpin order can ignore this.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Forgets everything about a frame, because the page in it was deleted and the frame goes back to the free list.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
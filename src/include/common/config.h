@@ -27,14 +27,34 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** An async commit is made durable at most ASYNC_COMMIT_DELAY after it returns. */
+extern std::chrono::milliseconds async_commit_delay;
+
+/** An async commit is made durable right away if ASYNC_COMMIT_MAX_LAG bytes of log are waiting to be flushed. */
+extern size_t async_commit_max_lag;
+
+/** A running background writer checks the number of clean frames every BGWRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bgwriter_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int HUGE_PAGE_SIZE = 2 * 1024 * 1024;                        // size of a huge page in byte
+static constexpr int CACHE_LINE_SIZE = 64;                                    // size of a cache line in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
+static constexpr int MAX_BUFFER_POOL_SIZE = 1024;                             // size the buffer pool can be resized to
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;  // accesses remembered per frame by the lru-k replacer
+static constexpr int BUFFER_ACCESS_STRATEGY_RING_SIZE = 32;  // frames a sequential scan or bulk insert cycles through
+static constexpr int OPTIMISTIC_READ_ATTEMPTS = 8;  // optimistic b+ tree descents before falling back to latching
+static constexpr int FETCH_BATCH_SIZE = 64;  // rids an index scan or index join reads from the table heap at once
+static constexpr int IO_QUEUE_DEPTH = 64;    // page reads and writes an async disk manager keeps in flight
+static constexpr int DISK_EXTENT_SIZE = 256;  // pages the db file grows by at once, behind one free-space bitmap
+static constexpr int VICTIM_CANDIDATES = 4;   // victims looked at for one that needs no log force before write back
+static constexpr int REDO_THREADS = 4;        // workers that redo the log in parallel, each owns a part of the pages
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
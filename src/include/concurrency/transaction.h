@@ -253,6 +253,16 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return true if Commit returns before the commit record is on disk */
+  inline bool IsAsyncCommit() const { return async_commit_; }
+
+  /**
+   * Let Commit return as soon as the commit record is in the log buffer, instead of waiting for it to be flushed.
+   * A crash may lose the transaction for up to async_commit_delay after it committed.
+   * @param async_commit whether the transaction commits asynchronously
+   */
+  inline void SetAsyncCommit(bool async_commit) { async_commit_ = async_commit; }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
@@ -267,8 +277,10 @@ class Transaction {
   std::shared_ptr<std::deque<TableWriteRecord>> table_write_set_;
   /** The undo set of indexes. */
   std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
-  /** The LSN of the last record written by the transaction. */
-  lsn_t prev_lsn_;
+  /** The LSN of the last record written by the transaction, atomic since a checkpoint reads it from another thread. */
+  std::atomic<lsn_t> prev_lsn_;
+  /** True if the transaction does not wait for its commit record to be flushed. */
+  bool async_commit_{false};
 
   /** Concurrent index: the pages that were latched during index operation. */
   std::shared_ptr<std::deque<Page *>> page_set_;
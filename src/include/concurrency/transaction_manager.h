@@ -13,6 +13,7 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 
@@ -74,6 +75,12 @@ class TransactionManager {
     return res;
   }
 
+  /**
+   * Take a snapshot of the active transaction table for a fuzzy checkpoint. Running transactions are not blocked.
+   * @return the lsn of the last log record of every transaction that has begun and not committed or aborted yet
+   */
+  std::unordered_map<txn_id_t, lsn_t> GetActiveTransactionTable();
+
   /** Prevents all transactions from performing operations, used for checkpointing. */
   void BlockAllTransactions();
 
@@ -98,12 +105,20 @@ class TransactionManager {
     }
   }
 
+  /** Take the transaction out of the active transaction table, once its commit or abort record is in the log. */
+  void RemoveActiveTransaction(Transaction *txn);
+
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** The transactions that have begun and not committed or aborted yet, protected by active_txns_latch_. */
+  std::unordered_map<txn_id_t, Transaction *> active_txns_;
+  /** Protects active_txns_ and the inserts into txn_map. */
+  std::mutex active_txns_latch_;
 };
 
 }  // namespace bustub
@@ -48,6 +48,12 @@ class IndexScanExecutor : public AbstractExecutor {
   IndexInfo *index_info_;
   IndexIterator<GenericKey<8>, RID, GenericComparator<8>> cur_iter_;
   IndexIterator<GenericKey<8>, RID, GenericComparator<8>> end_iter_;
+  /** Rids taken from the index for the current batch. */
+  std::vector<RID> batch_rids_;
+  /** Tuples of batch_rids_, read from the table heap together. */
+  std::vector<Tuple> batch_tuples_;
+  /** Position of the next tuple in the batch. */
+  size_t batch_pos_{0};
   // std::vector<uint32_t> out_schema_index_;
 };
 }  // namespace bustub
@@ -61,5 +61,14 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   const Schema *inner_table_schema_;
   const Schema *outer_table_schema_;
   const Schema *output_schema_;
+
+  /** Outer tuples of the current batch that found a match in the index. */
+  std::vector<Tuple> outer_batch_;
+  /** The inner rid each tuple of outer_batch_ matched. */
+  std::vector<RID> inner_rids_;
+  /** Inner tuples of inner_rids_, read from the table heap together. */
+  std::vector<Tuple> inner_batch_;
+  /** Position of the next pair in the batch. */
+  size_t batch_pos_{0};
 };
 }  // namespace bustub
@@ -19,7 +19,11 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager takes ARIES fuzzy checkpoints. Transactions and the buffer pool go on while it runs, nothing is
+ * written back: the checkpoint only logs the active transaction table and the dirty page table, between a
+ * BEGIN_CHECKPOINT and an END_CHECKPOINT record, with the parts that do not fit into the latter in CHECKPOINT_TABLES
+ * records in between. Recovery from the last complete checkpoint starts redo at the lowest recLSN in its dirty page
+ * table instead of at the start of the log.
  */
 class CheckpointManager {
  public:
@@ -31,13 +35,22 @@ class CheckpointManager {
 
   ~CheckpointManager() = default;
 
+  /** Append the BEGIN_CHECKPOINT record. Does nothing if logging is off. */
   void BeginCheckpoint();
+
+  /**
+   * Snapshot the active transaction table and the dirty page table, append them in CHECKPOINT_TABLES records and the
+   * END_CHECKPOINT record and flush the log up to the latter. The checkpoint is complete once this returns. Does
+   * nothing if logging is off.
+   */
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  /** The lsn of the BEGIN_CHECKPOINT record of the checkpoint under way. */
+  lsn_t begin_lsn_{INVALID_LSN};
 };
 
 }  // namespace bustub
@@ -13,9 +13,12 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,16 +28,28 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Appends do not take a latch: a record reserves its LSN and its place in the log buffer with one compare and swap
+ * on state_, which packs the next LSN together with the offset of the next free byte, so that records lie in the buffer
+ * in LSN order. The flush thread seals the buffer, waits until every reserved record is copied in, and swaps it with
+ * the flush buffer, so that appends go on into the other buffer while the sealed one is written.
+ *
+ * A committing transaction waits in FlushUntil until persistent_lsn_ covers its commit record. All commits that
+ * arrive while a flush is under way are written and synced together by the next one, which is group commit. An async
+ * commit does not wait, FlushLazily only sets a deadline by which the flush thread has to flush.
  */
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+      : persistent_lsn_(INVALID_LSN), flush_thread_(nullptr), disk_manager_(disk_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
+    if (flush_thread_ != nullptr) {
+      StopFlushThread();
+    }
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -46,29 +61,71 @@ class LogManager {
 
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  /**
+   * Block until every log record up to and including the given lsn is written and synced to disk. Wakes the flush
+   * thread to do it now instead of at the next timeout, or flushes in the calling thread if there is no flush thread.
+   * @param lsn the lsn that must become persistent, clamped to the last lsn handed out
+   */
+  void FlushUntil(lsn_t lsn);
+
+  /**
+   * Make sure that every log record up to and including the given lsn gets flushed without waiting for it: within
+   * async_commit_delay, or right away if async_commit_max_lag bytes of log are waiting. Flushes in the calling thread
+   * if there is no flush thread.
+   * @param lsn the lsn that must become persistent
+   */
+  void FlushLazily(lsn_t lsn);
+
+  inline lsn_t GetNextLSN() { return static_cast<lsn_t>(state_.load() >> 32); }
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline char *GetLogBuffer() { return log_buffer_; }
 
  private:
-  // TODO(students): you may add your own member variables
-
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** Set in the offset half of state_ while the flush thread swaps the buffers, appends wait until it is cleared. */
+  static constexpr uint64_t SEALED = uint64_t{1} << 31;
+
+  /**
+   * Seal the log buffer, swap it with the flush buffer and write it to disk, then advance persistent_lsn_. The latch
+   * must be held, it is released while the buffer is written. Only one flush runs at a time.
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
+
+  /** Serialize a log record into the given memory, which must have room for its size. */
+  static void SerializeLogRecord(LogRecord *log_record, char *data);
+
+  /**
+   * The next log sequence number in the upper 32 bits, the offset of the next free byte of log_buffer_ and the SEALED
+   * bit in the lower 32 bits.
+   */
+  std::atomic<uint64_t> state_{0};
+  /** The number of bytes copied into log_buffer_, the buffer may be written once it reaches the reserved offset. */
+  std::atomic<uint32_t> bytes_written_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
   char *log_buffer_;
   char *flush_buffer_;
 
+  /** Protects the flags below and the swap of the buffers. */
   std::mutex latch_;
-
-  std::thread *flush_thread_ __attribute__((__unused__));
-
+  /** Set when a commit or a full buffer wants the flush thread to flush before the timeout. */
+  bool flush_requested_{false};
+  /** The flush thread flushes at this time at the latest, set by async commits. */
+  std::chrono::steady_clock::time_point flush_deadline_{std::chrono::steady_clock::time_point::max()};
+  /** Set to make the flush thread flush one last time and exit. */
+  bool stop_{false};
+  /** Set while a flush writes the flush buffer. */
+  bool flushing_{false};
+
+  std::thread *flush_thread_;
+
+  /** Wakes the flush thread. */
   std::condition_variable cv_;
+  /** Signalled when the buffers were swapped and when persistent_lsn_ advanced. */
+  std::condition_variable flushed_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,8 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +34,12 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** The start of a fuzzy checkpoint, the tables in its END_CHECKPOINT are taken after it. */
+  BEGIN_CHECKPOINT,
+  /** A part of the tables of a fuzzy checkpoint, for tables too large to fit into its END_CHECKPOINT alone. */
+  CHECKPOINT_TABLES,
+  /** The end of a fuzzy checkpoint, carrying the last part of the active transaction table and the dirty page table. */
+  END_CHECKPOINT,
 };
 
 /**
@@ -54,9 +62,14 @@ enum class LogRecordType {
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *------------------------------------
+ * For checkpoint tables and end checkpoint type log records, whose prevLSN is the LSN of their begin checkpoint record.
+ * The tables of a checkpoint are the union of the parts in all of them
+ *-----------------------------------------------------------------------------------------
+ * | HEADER | txn_count | (txn_id, last_lsn) ... | page_count | (page_id, rec_lsn) ... |
+ *-----------------------------------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -110,6 +123,24 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for CHECKPOINT_TABLES/END_CHECKPOINT type
+  LogRecord(lsn_t begin_checkpoint_lsn, LogRecordType log_record_type,
+            std::unordered_map<txn_id_t, lsn_t> active_txn_table, std::unordered_map<page_id_t, lsn_t> dirty_page_table)
+      : prev_lsn_(begin_checkpoint_lsn),
+        log_record_type_(log_record_type),
+        active_txn_table_(std::move(active_txn_table)),
+        dirty_page_table_(std::move(dirty_page_table)) {
+    assert(log_record_type == LogRecordType::CHECKPOINT_TABLES || log_record_type == LogRecordType::END_CHECKPOINT);
+    // calculate log record size, header size + the two counts + the two tables
+    size_ = CheckpointRecordSize(active_txn_table_.size(), dirty_page_table_.size());
+  }
+
+  /** @return the size of a checkpoint record carrying the given number of transactions and pages */
+  static constexpr int32_t CheckpointRecordSize(size_t num_txns, size_t num_pages) {
+    return HEADER_SIZE + 2 * sizeof(int32_t) + num_txns * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+           num_pages * (sizeof(page_id_t) + sizeof(lsn_t));
+  }
+
   ~LogRecord() = default;
 
   inline Tuple &GetDeleteTuple() { return delete_tuple_; }
@@ -128,6 +159,12 @@ class LogRecord {
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline page_id_t GetNewPageId() { return page_id_; }
+
+  inline std::unordered_map<txn_id_t, lsn_t> &GetActiveTxnTable() { return active_txn_table_; }
+
+  inline std::unordered_map<page_id_t, lsn_t> &GetDirtyPageTable() { return dirty_page_table_; }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -176,6 +213,10 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for end checkpoint, the last lsn of every active transaction and the recLSN of every dirty page
+  std::unordered_map<txn_id_t, lsn_t> active_txn_table_;
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table_;
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
@@ -13,22 +13,37 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "recovery/log_record.h"
+#include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Redo runs the ARIES analysis pass before it repeats history. Analysis finds the last complete fuzzy checkpoint and
+ * rebuilds the dirty page table as of the crash from it, redo then starts at the lowest recLSN in that table instead
+ * of at the start of the log, and skips the changes to pages that were on disk already.
+ *
+ * Redo reads the log once and hands each record to one of several workers by the id of the page it changes. Every
+ * page belongs to one worker, which applies its records in lsn order, so different pages are redone in parallel.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, size_t num_redo_threads = REDO_THREADS)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        num_redo_threads_(std::max<size_t>(num_redo_threads, 1)),
+        offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -39,18 +54,74 @@ class LogRecovery {
 
   void Redo();
   void Undo();
-  bool DeserializeLogRecord(const char *data, LogRecord *log_record);
+  bool DeserializeLogRecord(const char *data, int size, LogRecord *log_record);
+
+  /** @return the lsn redo started at, INVALID_LSN if Redo has not found anything to redo */
+  lsn_t GetRedoLSN() const { return redo_lsn_; }
+
+  /** @return the number of log records Redo applied to a page */
+  size_t GetNumRedone() const { return num_redone_.load(); }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** A log record to redo on one of the pages it changes. */
+  struct RedoTask {
+    page_id_t page_id_;
+    LogRecord log_record_;
+  };
+
+  /** The tasks handed to one redo worker, in batches in lsn order. */
+  struct RedoQueue {
+    std::mutex latch_;
+    /** Signalled whenever a batch is added or taken, or the log is read to its end. */
+    std::condition_variable cv_;
+    std::deque<std::vector<RedoTask>> batches_;
+    bool done_{false};
+  };
+
+  /**
+   * Read the log record at the given offset of the log file, through log_buffer_.
+   * @return false at the end of the log
+   */
+  bool ReadLogRecord(int offset, LogRecord *log_record);
+
+  /** Analysis pass: build lsn_mapping_, active_txn_ and dirty_page_table_ from the log. */
+  void Analyze();
+
+  /** @return true if the record changes the given page, and the copy of the page on disk may be older than it */
+  bool NeedsRedo(LogRecord *log_record, page_id_t page_id);
+
+  /**
+   * Apply the change of a log record to one of the pages it changes, unless the page LSN shows it is there already.
+   * @param log_record the record to redo
+   * @param page_id the page to redo it on, the page before a new one only gets the link to it
+   */
+  void RedoLogRecord(LogRecord *log_record, page_id_t page_id);
+
+  /** Apply the batches of a queue until it is empty and done. */
+  void RunRedoWorker(RedoQueue *queue);
+
+  /** Apply the inverse of the change of a log record to its page. */
+  void UndoLogRecord(LogRecord *log_record);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  /** The number of workers Redo hands the records to. */
+  const size_t num_redo_threads_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
   std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** The recLSN of every page that may have been dirty at the crash, valid if a checkpoint was found. */
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table_;
+  /** True if the log holds a complete checkpoint, without one every page is redone from the start of the log. */
+  bool has_checkpoint_{false};
+  lsn_t redo_lsn_{INVALID_LSN};
+  std::atomic<size_t> num_redone_{0};
 
-  int offset_ __attribute__((__unused__));
+  /** The offset in the log file that log_buffer_ starts at, and how many bytes of it were read. */
+  int offset_;
+  int buffer_size_{0};
   char *log_buffer_;
 };
 
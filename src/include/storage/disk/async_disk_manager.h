@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * AsyncDiskManager is a DiskManager that submits page reads and writes through io_uring, so that many of them can be
+ * in flight at once. ReadPages and WritePages submit a whole batch with one system call and return once all of it is
+ * done, ReadPageAsync and WritePageAsync return a future right after submitting. A thread of its own reaps the
+ * completions and fulfills the futures.
+ *
+ * Pages inside a range given to RegisterBuffers, such as the frames of a buffer pool, are read and written with fixed
+ * buffer operations, which spare the kernel mapping the buffer on every request.
+ *
+ * If the kernel has no io_uring or does not allow it, every operation falls back to the synchronous pread and pwrite
+ * of DiskManager, and the futures are ready by the time they are returned.
+ *
+ * In direct I/O mode, requests for buffers that are not PAGE_SIZE aligned are served through an aligned copy that lives
+ * as long as the request.
+ */
+class AsyncDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new async disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the number of requests that may be in flight at once
+   * @param direct_io whether to bypass the kernel page cache for the database file, see DiskManager
+   */
+  explicit AsyncDiskManager(const std::string &db_file, size_t queue_depth = IO_QUEUE_DEPTH, bool direct_io = false);
+
+  ~AsyncDiskManager() override;
+
+  /**
+   * Wait for all requests in flight, tear down the ring and close all the file resources.
+   */
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) override;
+
+  void ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) override;
+
+  /**
+   * Submit the write of a page. The page data must stay unchanged until the future is ready.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return a future that is ready once the page is written
+   */
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Submit the read of a page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, filled once the future is ready
+   * @return a future that is ready once the page is read
+   */
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  bool RegisterBuffers(char *data, size_t size) override;
+
+  void UnregisterBuffers(char *data) override;
+
+  /** @return true if requests go through io_uring, false if they fall back to synchronous I/O */
+  bool IsUringEnabled() const { return ring_fd_ >= 0; }
+
+ private:
+  /** One page read or write in flight. The user data of its submission queue entry points to it. */
+  struct Request {
+    bool is_write_;
+    page_id_t page_id_;
+    char *data_;
+    /** An aligned copy of data_ that the kernel reads or writes instead, if direct I/O needs one. */
+    char *bounce_;
+    std::promise<void> promise_;
+  };
+
+  /** Create a request for a page, with an aligned copy of its data if direct I/O needs one. */
+  Request *MakeRequest(bool is_write, page_id_t page_id, char *data);
+
+  /** Set up the ring with the given number of entries. @return false if the kernel does not allow io_uring */
+  bool SetUpRing(unsigned entries);
+
+  /** Stop the reaper and unmap and close the ring, once no request is in flight. */
+  void TearDownRing();
+
+  /** Submit the requests and wait until all of them are done. */
+  void SubmitAndWait(const std::vector<Request *> &requests);
+
+  /**
+   * Put the requests into the submission queue and hand them to the kernel, as many at a time as the queue depth
+   * allows. Ownership of the requests passes to the reaper.
+   */
+  void Submit(const std::vector<Request *> &requests);
+
+  /** Fill the next submission queue entry for a request, or for the no-op that stops the reaper if it is nullptr. */
+  void Prepare(Request *request);
+
+  /** Hand the given number of queued entries to the kernel. Must be called with latch_ held. */
+  void Enter(unsigned to_submit);
+
+  /** Register buffers_ with the ring, replacing what was registered before. Must be called with latch_ held. */
+  bool UpdateBuffers();
+
+  /** Wait for completions and finish their requests until the stop entry completes. */
+  void RunReaper();
+
+  /** Finish a request that completed with the given result, then delete it. */
+  void Complete(Request *request, int result);
+
+  /** File descriptor of the ring, -1 if io_uring is not used. */
+  int ring_fd_{-1};
+  /** The number of requests that may be in flight, never more than the submission queue holds. */
+  unsigned queue_depth_{0};
+
+  /** The mapped rings and the pointers into them, see io_uring_setup(2). */
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+
+  /** Protects the submission queue, in_flight_ and buffers_. */
+  std::mutex latch_;
+  /** Signalled whenever requests complete. */
+  std::condition_variable in_flight_cv_;
+  /** The number of requests submitted but not yet reaped. */
+  unsigned in_flight_{0};
+  /** The registered ranges, in the order of their buffer indexes. */
+  std::vector<iovec> buffers_;
+  /** Reaps completions, runs as long as the ring is set up. */
+  std::thread reaper_thread_;
+};
+
+}  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <sys/types.h>
+#include <sys/uio.h>
 #include <atomic>
-#include <fstream>
 #include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
 
@@ -24,38 +29,93 @@ namespace bustub {
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O on a file descriptor, which keeps no cursor, so any number of threads
+ * may read and write pages at the same time.
+ *
+ * The db file is made of extents of DISK_EXTENT_SIZE pages. Each extent starts with a header page that holds a bitmap
+ * of the pages in it that are allocated, so pages given back with DeallocatePage are reused and the allocation
+ * state survives a restart. The file grows by whole extents, which are preallocated with fallocate where the file
+ * system supports it.
+ *
+ * Allocating and deallocating a page only changes the bitmap in memory, so it can be done under the latch of a buffer
+ * pool. The extents that grew and the headers that changed go to disk before the next page is written, and on Sync and
+ * ShutDown, so a page is never in the file before its header says it is allocated.
+ *
+ * In direct I/O mode the db file is opened with O_DIRECT, so pages are cached only by the buffer pool and not in the
+ * kernel page cache as well. The frames of a buffer pool are PAGE_SIZE aligned and go to disk as they are, other
+ * buffers go through an aligned copy.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io whether to bypass the kernel page cache for the database file, ignored where the file system does
+   * not support it
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
 
   /**
-   * Flush the entire log buffer into disk.
+   * Write a batch of pages to the database file and return once all of them are written. A disk manager that can keep
+   * several requests in flight submits them together, this one writes them in page id order and every run of pages
+   * that are adjacent in the file with a single pwritev.
+   * @param page_ids ids of the pages
+   * @param page_data raw page data, one entry per page id
+   */
+  virtual void WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data);
+
+  /**
+   * Read a batch of pages from the database file and return once all of them are read.
+   * @param page_ids ids of the pages
+   * @param[out] page_data output buffers, one entry per page id
+   */
+  virtual void ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data);
+
+  /**
+   * Force everything written to the database file so far to stable storage.
+   */
+  void Sync();
+
+  /**
+   * Tell the disk manager about a range of memory that many pages are read into and written from, such as the frames
+   * of a buffer pool, so that it can prepare it for I/O once instead of on every request. Registering a range again
+   * with the same start replaces it.
+   * @param data start of the range
+   * @param size size of the range in bytes
+   * @return true if the range was registered, false if this disk manager does not register buffers
+   */
+  virtual bool RegisterBuffers(char *data, size_t size) { return false; }
+
+  /**
+   * Forget a range registered with RegisterBuffers. Must be called before the memory is unmapped or released.
+   * @param data start of the range
+   */
+  virtual void UnregisterBuffers(char *data) {}
+
+  /**
+   * Flush the entire log buffer into disk. Returns once the log is synced to the device.
    * @param log_data raw log data
    * @param size size of log entry
    */
@@ -71,17 +131,25 @@ class DiskManager {
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk. Free pages are handed out lowest page id first, so deallocated pages are reused before
+   * the file grows. No I/O is done, the extent header is written before the next page write.
+   * @param stride only page ids congruent to offset modulo stride are allocated, so that several buffer pool
+   * instances can share one file without their page ids colliding
+   * @param offset see stride
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t offset = 0);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that it can be allocated again. Pages that are not allocated are ignored. No I/O is
+   * done, the extent header is written before the next page write.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return one more than the highest allocated page id, 0 if no page is allocated */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +159,15 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of disk reads */
+  int GetNumReads() const;
+
+  /** @return the number of times the database file was synced */
+  int GetNumSyncs() const { return num_syncs_; }
+
+  /** @return true if the db file is accessed with direct I/O */
+  bool IsDirectIo() const { return direct_io_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -100,19 +177,97 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
- private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+ protected:
+  /** @return true if the buffer can be used for direct I/O as it is */
+  static bool IsAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0; }
+
+  /** @return the offset of a page in the db file, behind the header page of its extent */
+  static off_t PageOffset(page_id_t page_id) {
+    return (static_cast<off_t>(page_id) + page_id / DISK_EXTENT_SIZE + 1) * PAGE_SIZE;
+  }
+
+  /** @return the offset of the header page of an extent in the db file */
+  static off_t ExtentOffset(size_t extent) { return static_cast<off_t>(extent) * (DISK_EXTENT_SIZE + 1) * PAGE_SIZE; }
+
+  /** @return a PAGE_SIZE aligned buffer of size bytes, a multiple of PAGE_SIZE, to be released with free() */
+  static char *AllocateAligned(size_t size);
+
+  /**
+   * Write the whole buffer at the given offset of the db file, retrying short writes.
+   * @return false on an I/O error
+   */
+  bool WriteAt(const char *data, size_t size, off_t offset);
+
+  /**
+   * Write the buffers one after another at the given offset of the db file, retrying short writes.
+   * @return false on an I/O error
+   */
+  bool WriteVAt(std::vector<iovec> buffers, off_t offset);
+
+  /**
+   * Read into the buffer from the given offset of the db file until it is full or the file ends.
+   * @return the number of bytes read
+   */
+  size_t ReadAt(char *data, size_t size, off_t offset);
+
+  /** @return the size of the file in bytes, -1 if it does not exist */
+  off_t GetFileSize(const std::string &file_name);
+
+  /** Raise the cached size of the db file to end, if it is smaller. Called after every write to the db file. */
+  void ExtendFileSize(off_t end);
+
+  /**
+   * Preallocate the extents added since the last call and write the extent headers that changed. Called before pages
+   * are written and before the db file is synced, must not be called with alloc_latch_ held.
+   */
+  void WriteExtentHeaders();
+
+  // file descriptor of the log file, -1 once it is closed
+  int log_fd_{-1};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file, -1 once it is closed
+  int db_fd_{-1};
+  // whether db_fd_ was opened with O_DIRECT
+  bool direct_io_{false};
+  // size of the db file in bytes, kept up to date by the writes instead of asking the file system
+  std::atomic<off_t> file_size_{0};
   std::string file_name_;
+  // one more than the highest allocated page id
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_reads_;
+  std::atomic<int> num_syncs_{0};
+
+ private:
+  /** Read the extent headers of an existing db file into page_bitmap_ and restore next_page_id_. */
+  void LoadExtents();
+
+  /** Add one more extent to page_bitmap_, WriteExtentHeaders preallocates it. alloc_latch_ must be held. */
+  void AddExtent();
+
+  /** Fill a header page of an extent from page_bitmap_. alloc_latch_ must be held. */
+  void BuildExtentHeader(size_t extent, char *header) const;
+
+  /** @return true if the page is allocated, it must be covered by page_bitmap_ */
+  bool IsAllocated(page_id_t page_id) const { return (page_bitmap_[page_id / 8] & (1 << (page_id % 8))) != 0; }
+
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // protects page_bitmap_, alloc_hints_ and dirty_extents_
+  std::mutex alloc_latch_;
+  // one bit per page of every extent in the db file, set if the page is allocated
+  std::vector<uint8_t> page_bitmap_;
+  // per stride and offset, the lowest page id that may be free
+  std::unordered_map<uint64_t, page_id_t> alloc_hints_;
+  // extents whose header on disk is behind page_bitmap_
+  std::set<size_t> dirty_extents_;
+  // set while dirty_extents_ is not empty or its headers are being written, so a page write checks it without a latch
+  std::atomic<bool> extents_dirty_{false};
+  // serializes WriteExtentHeaders, so that an older copy of a header never overwrites a newer one
+  std::mutex extent_io_latch_;
+  // number of extents at the start of the db file that are preallocated, protected by extent_io_latch_
+  size_t num_preallocated_extents_{0};
 };
 
 }  // namespace bustub
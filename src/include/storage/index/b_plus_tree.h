@@ -10,6 +10,8 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <fstream>
 #include <queue>
 #include <string>
 #include <utility>
@@ -83,6 +85,14 @@ class BPlusTree {
   // expose for test purpose
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
+  /**
+   * Descend to the leaf that holds key without latching the inner pages. Every inner page is read optimistically and
+   * validated against its version before its child is used, and only the leaf is latched. The descent restarts when a
+   * writer got in the way, and gives up after OPTIMISTIC_READ_ATTEMPTS tries.
+   * @return the read latched leaf, empty if the descent kept conflicting with writers
+   */
+  ReadPageGuard FindLeafPageOptimistic(const KeyType &key);
+
   std::pair<Page *, bool *> FindLeafPageByOperation(const KeyType &key, OperationType op, Transaction *transaction,
                                                     bool leftMost = false);
 
@@ -92,6 +102,12 @@ class BPlusTree {
   void UnlatchAndUnpin(Transaction *transaction, OperationType op);
   void UnlatchAndUnpinAndDelete(Transaction *transaction, OperationType op);
 
+  /**
+   * Find a page that the descent of FindLeafPageByOperation kept write latched, such as the parent of an unsafe node.
+   * @return the page from the page set of the transaction, nullptr if it is not there
+   */
+  Page *GetLatchedPage(Transaction *transaction, page_id_t page_id);
+
  private:
   void StartNewTree(const KeyType &key, const ValueType &value);
 
@@ -100,8 +116,9 @@ class BPlusTree {
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                         Transaction *transaction = nullptr, bool *is_root_lock = nullptr);
 
+  /** Move the upper half of node to a new sibling. The returned guard holds the pin on the sibling. */
   template <typename N>
-  N *Split(N *node);
+  BasicPageGuard Split(N *node);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr, bool *is_root_lock = nullptr);
@@ -111,7 +128,7 @@ class BPlusTree {
                 int index, Transaction *transaction = nullptr, bool *is_root_lock = nullptr);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent_node, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -124,7 +141,8 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  /** Atomic, optimistic readers look it up without taking root_latch_. */
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
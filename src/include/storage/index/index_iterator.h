@@ -41,6 +41,9 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const { return !(itr == *this); }
 
  private:
+  /** Prefetch the leaf after the current one, if there is one. */
+  void ReadAhead();
+
   BufferPoolManager *buffer_pool_manager_;
   Page *page_;
   int index_;
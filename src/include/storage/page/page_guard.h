@@ -0,0 +1,221 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds the pin on a page and unpins it when it goes out of scope, so that no return path can leak the
+ * pin. The guard remembers whether the page was modified through it and passes that on to UnpinPage. It is move-only,
+ * moving it hands the pin over to the new guard.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over the pin on a page.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Unpin the page this guard holds, if any, then take over the page of that guard. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now, the guard is empty afterwards. Dropping an empty guard does nothing. */
+  void Drop();
+
+  /**
+   * Latch the page for reading and hand the pin over to a ReadPageGuard. This guard is empty afterwards.
+   * @return the read guard, empty if this guard was empty
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Latch the page for writing and hand the pin over to a WritePageGuard. This guard is empty afterwards.
+   * @return the write guard, empty if this guard was empty
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page, false if fetching it failed or the guard was dropped or moved from */
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page, for reading */
+  const char *GetData() { return page_->GetData(); }
+
+  /** @return the data of the guarded page, for writing. Marks the page dirty. */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /**
+   * View the guarded page as T, without marking it dirty. T is either a subclass of Page, such as TablePage, or a
+   * layout that is overlaid on the page data, such as a B+ tree page.
+   */
+  template <class T>
+  T *As() {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  /** View the guarded page as T, like As, and mark it dirty. */
+  template <class T>
+  T *AsMut() {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+  /** Mark the page dirty, for callers that modified it through a view they took earlier. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds the pin and the read latch on a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over the pin and the read latch on a page.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned and read latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Unlatch and unpin the page this guard holds, if any, then take over the page of that guard. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** View the guarded page as T, see BasicPageGuard::As. */
+  template <class T>
+  T *As() {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds the pin and the write latch on a page, and releases both when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over the pin and the write latch on a page.
+   * @param bpm the buffer pool the page was fetched from
+   * @param page the pinned and write latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Unlatch and unpin the page this guard holds, if any, then take over the page of that guard. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, the guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page, for reading */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, for writing. Marks the page dirty. */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  /** View the guarded page as T without marking it dirty, see BasicPageGuard::As. */
+  template <class T>
+  T *As() {
+    return guard_.As<T>();
+  }
+
+  /** View the guarded page as T and mark it dirty. */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  /** Mark the page dirty. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
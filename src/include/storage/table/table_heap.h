@@ -95,9 +95,20 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param strategy access strategy of the scan the read belongs to, nullptr for a point read
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Read a batch of tuples from the table. The rids are visited in page order, so every page is fetched once no matter
+   * how many of its tuples are read, and the pages are fetched in batches that read their misses together.
+   * @param rids rids of the tuples to read
+   * @param[out] tuples the tuples in the order of rids, a tuple that could not be read is left unallocated
+   * @param txn transaction performing the read
+   * @return true if every tuple was read
+   */
+  bool GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn);
 
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -21,9 +23,12 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ * The scan reads through a BufferAccessStrategy, so it only cycles through a small ring of frames of the buffer pool.
+ * While it is on a page, the next page of the heap is prefetched into the ring.
  */
 class TableIterator {
   friend class Cursor;
@@ -32,7 +37,11 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        prefetched_page_id_(other.prefetched_page_id_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +61,25 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    prefetched_page_id_ = other.prefetched_page_id_;
     return *this;
   }
 
  private:
+  /**
+   * Prefetch the page after the one the iterator is on, unless that was done already.
+   * @param cur_page the page the iterator is on, latched
+   */
+  void ReadAhead(TablePage *cur_page);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Ring of the scan, shared by copies of the iterator since they continue the same scan. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** The page the last read-ahead was issued for, so every page is only prefetched once. */
+  page_id_t prefetched_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
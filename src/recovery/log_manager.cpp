@@ -12,7 +12,16 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
+#include "common/macros.h"
+
 namespace bustub {
+
+// The lower half of state_ holds the offset into the log buffer and the SEALED bit, the upper half the next lsn.
+static constexpr uint64_t OFFSET_MASK = 0xffffffff;
+static constexpr uint64_t LSN_ONE = uint64_t{1} << 32;
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
@@ -22,33 +31,226 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  stop_ = false;
+  enable_logging = true;
+  flush_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+      // Sleep until the timeout, a request, or the deadline of an async commit, which may move closer while we sleep.
+      auto timeout = std::chrono::steady_clock::now() + log_timeout;
+      while (!flush_requested_ && !stop_) {
+        auto deadline = std::min(timeout, flush_deadline_);
+        if (std::chrono::steady_clock::now() >= deadline) {
+          break;
+        }
+        cv_.wait_until(lock, deadline);
+      }
+      bool stop = stop_;
+      FlushBuffer(&lock);
+      if (stop) {
+        return;
+      }
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
+ * The thread flushes what is left in the log buffer before it exits
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    flush_thread = flush_thread_;
+    stop_ = true;
+  }
+  if (flush_thread != nullptr) {
+    cv_.notify_one();
+    flush_thread->join();
+    delete flush_thread;
+  }
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    flush_thread_ = nullptr;
+    stop_ = false;
+  }
+  enable_logging = false;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
  *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * The lsn and the room in the buffer are reserved together with one compare and swap, so no latch is taken unless
+ * the buffer is full
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  const auto size = static_cast<uint64_t>(log_record->GetSize());
+  BUSTUB_ASSERT(size <= static_cast<uint64_t>(LOG_BUFFER_SIZE), "log record larger than the log buffer");
+
+  // 1.   Reserve the next lsn and room for the record in the log buffer.
+  uint64_t state = state_.load();
+  while (true) {
+    uint64_t offset = state & OFFSET_MASK;
+    if ((offset & SEALED) == 0 && offset + size <= static_cast<uint64_t>(LOG_BUFFER_SIZE)) {
+      if (state_.compare_exchange_weak(state, state + LSN_ONE + size)) {
+        break;
+      }
+      continue;
+    }
+    // 2.   The buffer is full or being swapped. Have it flushed, and retry once the buffers are swapped.
+    std::unique_lock<std::mutex> lock(latch_);
+    if (state_.load() == state) {
+      if (flush_thread_ == nullptr || stop_) {
+        FlushBuffer(&lock);
+      } else {
+        flush_requested_ = true;
+        cv_.notify_one();
+        flushed_cv_.wait(lock, [&] { return state_.load() != state; });
+      }
+    }
+    state = state_.load();
+  }
+
+  // 3.   Copy the record into its place. The buffer is not swapped before every reserved record is counted as written.
+  log_record->lsn_ = static_cast<lsn_t>(state >> 32);
+  SerializeLogRecord(log_record, log_buffer_ + (state & OFFSET_MASK));
+  bytes_written_ += size;
+  return log_record->lsn_;
+}
+
+void LogManager::FlushUntil(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr || stop_) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+void LogManager::FlushLazily(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  if (flush_thread_ == nullptr || stop_) {
+    lock.unlock();
+    FlushUntil(lsn);
+    return;
+  }
+  auto deadline = std::chrono::steady_clock::now() + async_commit_delay;
+  bool wake = false;
+  if (deadline < flush_deadline_) {
+    flush_deadline_ = deadline;
+    wake = true;
+  }
+  if ((state_.load() & (SEALED - 1)) >= async_commit_max_lag) {
+    flush_requested_ = true;
+    wake = true;
+  }
+  if (wake) {
+    cv_.notify_one();
+  }
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  // 1.   Wait for the flush under way, its buffer is the one we are going to swap in.
+  flushed_cv_.wait(*lock, [this] { return !flushing_; });
+  flush_requested_ = false;
+  flush_deadline_ = std::chrono::steady_clock::time_point::max();
+  if ((state_.load() & OFFSET_MASK) == 0) {
+    return;
+  }
+
+  // 2.   Seal the buffer, and wait for the appends that reserved room in it to finish copying.
+  uint64_t state = state_.fetch_or(SEALED);
+  auto size = static_cast<uint32_t>(state & OFFSET_MASK);
+  while (bytes_written_.load() != size) {
+    std::this_thread::yield();
+  }
+
+  // 3.   Swap the buffers and let the appends go on into the empty one.
+  std::swap(log_buffer_, flush_buffer_);
+  bytes_written_ = 0;
+  state_ = state & ~OFFSET_MASK;
+  flushing_ = true;
+  flushed_cv_.notify_all();
+
+  // 4.   Write and sync the sealed buffer without the latch, then publish the last lsn in it.
+  lock->unlock();
+  disk_manager_->WriteLog(flush_buffer_, static_cast<int>(size));
+  lock->lock();
+  persistent_lsn_ = static_cast<lsn_t>(state >> 32) - 1;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *data) {
+  // First, serialize the must have fields (20 bytes in total)
+  int pos = 0;
+  auto put = [&](const void *field, size_t size) {
+    memcpy(data + pos, field, size);
+    pos += size;
+  };
+  put(&log_record->size_, sizeof(log_record->size_));
+  put(&log_record->lsn_, sizeof(log_record->lsn_));
+  put(&log_record->txn_id_, sizeof(log_record->txn_id_));
+  put(&log_record->prev_lsn_, sizeof(log_record->prev_lsn_));
+  put(&log_record->log_record_type_, sizeof(log_record->log_record_type_));
+  BUSTUB_ASSERT(pos == LogRecord::HEADER_SIZE, "log record header must be 20 bytes");
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      put(&log_record->insert_rid_, sizeof(RID));
+      log_record->insert_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      put(&log_record->delete_rid_, sizeof(RID));
+      log_record->delete_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      put(&log_record->update_rid_, sizeof(RID));
+      log_record->old_tuple_.SerializeTo(data + pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      put(&log_record->prev_page_id_, sizeof(page_id_t));
+      put(&log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::CHECKPOINT_TABLES:
+    case LogRecordType::END_CHECKPOINT: {
+      auto num_txns = static_cast<int32_t>(log_record->active_txn_table_.size());
+      put(&num_txns, sizeof(num_txns));
+      for (const auto &[txn_id, lsn] : log_record->active_txn_table_) {
+        put(&txn_id, sizeof(txn_id));
+        put(&lsn, sizeof(lsn));
+      }
+      auto num_pages = static_cast<int32_t>(log_record->dirty_page_table_.size());
+      put(&num_pages, sizeof(num_pages));
+      for (const auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+        put(&page_id, sizeof(page_id));
+        put(&rec_lsn, sizeof(rec_lsn));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
 
 }  // namespace bustub
@@ -12,15 +12,128 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
+
+// Records are handed to a worker in batches of at most REDO_BATCH_SIZE, and the log is read at most REDO_QUEUE_BATCHES
+// batches ahead of each worker.
+static constexpr size_t REDO_BATCH_SIZE = 64;
+static constexpr size_t REDO_QUEUE_BATCHES = 4;
+
+/** @return the pages a log record changes, the second one is INVALID_PAGE_ID unless it creates a page */
+static std::pair<page_id_t, page_id_t> ChangedPages(LogRecord *log_record) {
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::INSERT:
+      return {log_record->GetInsertRID().GetPageId(), INVALID_PAGE_ID};
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return {log_record->GetDeleteRID().GetPageId(), INVALID_PAGE_ID};
+    case LogRecordType::UPDATE:
+      return {log_record->GetUpdateRID().GetPageId(), INVALID_PAGE_ID};
+    case LogRecordType::NEWPAGE:
+      // Creating a page links it to the page before, which is not logged apart.
+      return {log_record->GetNewPageId(), log_record->GetNewPageRecord()};
+    default:
+      return {INVALID_PAGE_ID, INVALID_PAGE_ID};
+  }
+}
+
 /*
  * deserialize a log record from log buffer
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, int size, LogRecord *log_record) {
+  if (size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int pos = 0;
+  auto get = [&](void *field, size_t field_size) {
+    memcpy(field, data + pos, field_size);
+    pos += field_size;
+  };
+  get(&log_record->size_, sizeof(log_record->size_));
+  get(&log_record->lsn_, sizeof(log_record->lsn_));
+  get(&log_record->txn_id_, sizeof(log_record->txn_id_));
+  get(&log_record->prev_lsn_, sizeof(log_record->prev_lsn_));
+  get(&log_record->log_record_type_, sizeof(log_record->log_record_type_));
+  // The log file ends in zeros, or in a record that was cut short by the crash.
+  if (log_record->size_ < LogRecord::HEADER_SIZE || log_record->size_ > size ||
+      log_record->log_record_type_ <= LogRecordType::INVALID ||
+      log_record->log_record_type_ > LogRecordType::END_CHECKPOINT) {
+    return false;
+  }
+  auto get_tuple = [&](Tuple *tuple) {
+    int32_t length;
+    memcpy(&length, data + pos, sizeof(length));
+    if (length < 0 || pos + static_cast<int>(sizeof(length)) + length > log_record->size_) {
+      return false;
+    }
+    tuple->DeserializeFrom(data + pos);
+    pos += sizeof(length) + length;
+    return true;
+  };
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      get(&log_record->insert_rid_, sizeof(RID));
+      return get_tuple(&log_record->insert_tuple_);
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      get(&log_record->delete_rid_, sizeof(RID));
+      return get_tuple(&log_record->delete_tuple_);
+    case LogRecordType::UPDATE:
+      get(&log_record->update_rid_, sizeof(RID));
+      return get_tuple(&log_record->old_tuple_) && get_tuple(&log_record->new_tuple_);
+    case LogRecordType::NEWPAGE:
+      get(&log_record->prev_page_id_, sizeof(page_id_t));
+      get(&log_record->page_id_, sizeof(page_id_t));
+      return true;
+    case LogRecordType::CHECKPOINT_TABLES:
+    case LogRecordType::END_CHECKPOINT: {
+      log_record->active_txn_table_.clear();
+      log_record->dirty_page_table_.clear();
+      int32_t num_txns;
+      get(&num_txns, sizeof(num_txns));
+      if (num_txns < 0 || pos + num_txns * static_cast<int>(sizeof(txn_id_t) + sizeof(lsn_t)) > log_record->size_) {
+        return false;
+      }
+      for (int32_t i = 0; i < num_txns; i++) {
+        txn_id_t txn_id;
+        lsn_t lsn;
+        get(&txn_id, sizeof(txn_id));
+        get(&lsn, sizeof(lsn));
+        log_record->active_txn_table_[txn_id] = lsn;
+      }
+      int32_t num_pages;
+      get(&num_pages, sizeof(num_pages));
+      if (num_pages < 0 || pos + num_pages * static_cast<int>(sizeof(page_id_t) + sizeof(lsn_t)) > log_record->size_) {
+        return false;
+      }
+      for (int32_t i = 0; i < num_pages; i++) {
+        page_id_t page_id;
+        lsn_t rec_lsn;
+        get(&page_id, sizeof(page_id));
+        get(&rec_lsn, sizeof(rec_lsn));
+        log_record->dirty_page_table_[page_id] = rec_lsn;
+      }
+      return pos == log_record->size_;
+    }
+    default:
+      return true;
+  }
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -28,13 +141,293 @@ bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *log buffer to reduce unnecessary I/O operations), remember to compare page's
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
+ *
+ *The analysis pass reads the whole log, redo only reads it from the lowest
+ *recLSN of the dirty page table on
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  Analyze();
+  redo_lsn_ = INVALID_LSN;
+  num_redone_ = 0;
+  lsn_t redo_lsn = 0;
+  if (has_checkpoint_) {
+    // Nothing before the lowest recLSN can be missing from disk. No dirty page at all leaves nothing to redo.
+    redo_lsn = std::numeric_limits<lsn_t>::max();
+    for (const auto &[page_id, rec_lsn] : dirty_page_table_) {
+      redo_lsn = std::min(redo_lsn, std::max<lsn_t>(rec_lsn, 0));
+    }
+  }
+  auto iter = lsn_mapping_.find(redo_lsn);
+  if (iter == lsn_mapping_.end()) {
+    return;
+  }
+  redo_lsn_ = redo_lsn;
+
+  // 1.   Start the workers. A page belongs to the worker its id hashes to, so its records are applied in lsn order.
+  // 2.   Read the log once from redo_lsn_ on, and hand each record to the worker of every page it has to be redone on.
+  //      Records go over in batches, and the reader stalls once a worker has REDO_QUEUE_BATCHES of them waiting.
+  // 3.   Hand over what is left, and wait for the workers to finish.
+  std::vector<RedoQueue> queues(num_redo_threads_);
+  std::vector<std::thread> workers;
+  for (auto &queue : queues) {
+    workers.emplace_back(&LogRecovery::RunRedoWorker, this, &queue);
+  }
+  std::vector<std::vector<RedoTask>> pending(num_redo_threads_);
+  auto hand_over = [&](size_t worker) {
+    RedoQueue &queue = queues[worker];
+    {
+      std::unique_lock<std::mutex> lock(queue.latch_);
+      queue.cv_.wait(lock, [&queue] { return queue.batches_.size() < REDO_QUEUE_BATCHES; });
+      queue.batches_.push_back(std::move(pending[worker]));
+    }
+    queue.cv_.notify_all();
+    pending[worker].clear();
+  };
+
+  LogRecord log_record;
+  for (int offset = iter->second; ReadLogRecord(offset, &log_record); offset += log_record.GetSize()) {
+    auto [page_id, prev_page_id] = ChangedPages(&log_record);
+    for (page_id_t changed : {page_id, prev_page_id}) {
+      if (changed == INVALID_PAGE_ID || !NeedsRedo(&log_record, changed)) {
+        continue;
+      }
+      size_t worker = static_cast<size_t>(changed) % num_redo_threads_;
+      pending[worker].push_back(RedoTask{changed, log_record});
+      if (pending[worker].size() >= REDO_BATCH_SIZE) {
+        hand_over(worker);
+      }
+    }
+  }
+
+  for (size_t worker = 0; worker < num_redo_threads_; worker++) {
+    if (!pending[worker].empty()) {
+      hand_over(worker);
+    }
+    {
+      std::lock_guard<std::mutex> guard(queues[worker].latch_);
+      queues[worker].done_ = true;
+    }
+    queues[worker].cv_.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void LogRecovery::RunRedoWorker(RedoQueue *queue) {
+  while (true) {
+    std::vector<RedoTask> batch;
+    {
+      std::unique_lock<std::mutex> lock(queue->latch_);
+      queue->cv_.wait(lock, [queue] { return !queue->batches_.empty() || queue->done_; });
+      if (queue->batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches_.front());
+      queue->batches_.pop_front();
+    }
+    queue->cv_.notify_all();
+    for (RedoTask &task : batch) {
+      RedoLogRecord(&task.log_record_, task.page_id_);
+    }
+  }
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
+ *
+ *The records of all the losers are undone newest first, the order they were
+ *written in the other way round
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  std::priority_queue<lsn_t> to_undo;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    to_undo.push(lsn);
+  }
+  LogRecord log_record;
+  while (!to_undo.empty()) {
+    lsn_t lsn = to_undo.top();
+    to_undo.pop();
+    auto iter = lsn_mapping_.find(lsn);
+    BUSTUB_ASSERT(iter != lsn_mapping_.end(), "The log record of a loser must be in the log.");
+    bool read = ReadLogRecord(iter->second, &log_record);
+    BUSTUB_ASSERT(read && log_record.GetLSN() == lsn, "The log record must be at its offset.");
+    UndoLogRecord(&log_record);
+    if (log_record.GetPrevLSN() != INVALID_LSN) {
+      to_undo.push(log_record.GetPrevLSN());
+    }
+  }
+}
+
+bool LogRecovery::ReadLogRecord(int offset, LogRecord *log_record) {
+  // Records are read through log_buffer_, which is refilled from the record on whenever it does not hold all of it.
+  if (offset >= offset_ && offset < offset_ + buffer_size_ &&
+      DeserializeLogRecord(log_buffer_ + (offset - offset_), offset_ + buffer_size_ - offset, log_record)) {
+    return true;
+  }
+  buffer_size_ = 0;
+  if (!disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset)) {
+    return false;
+  }
+  offset_ = offset;
+  buffer_size_ = LOG_BUFFER_SIZE;
+  return DeserializeLogRecord(log_buffer_, buffer_size_, log_record);
+}
+
+void LogRecovery::Analyze() {
+  // 1.   Scan the log from its start. There is no master record that points at the last checkpoint, and undo needs the
+  //      offset of every record of a loser, which may be older than the checkpoint.
+  // 2.   From every BEGIN_CHECKPOINT on, remember the first lsn that changed each page, and collect the parts of the
+  //      dirty page table in its CHECKPOINT_TABLES records. Once its END_CHECKPOINT is read, the dirty page table is
+  //      the union of all parts, plus the pages changed since the begin record that are missing from it, or have a
+  //      later recLSN in it.
+  // 3.   After a complete checkpoint, every page changed that is not in the table yet goes in with the lsn of the
+  //      record that changed it.
+  lsn_mapping_.clear();
+  active_txn_.clear();
+  dirty_page_table_.clear();
+  has_checkpoint_ = false;
+  lsn_t begin_lsn = INVALID_LSN;
+  std::unordered_map<page_id_t, lsn_t> changed_since_begin;
+  std::unordered_map<page_id_t, lsn_t> checkpoint_pages;
+  LogRecord log_record;
+  for (int offset = 0; ReadLogRecord(offset, &log_record); offset += log_record.GetSize()) {
+    lsn_t lsn = log_record.GetLSN();
+    lsn_mapping_[lsn] = offset;
+    switch (log_record.GetLogRecordType()) {
+      case LogRecordType::BEGIN_CHECKPOINT:
+        begin_lsn = lsn;
+        changed_since_begin.clear();
+        checkpoint_pages.clear();
+        break;
+      case LogRecordType::CHECKPOINT_TABLES:
+        if (log_record.GetPrevLSN() == begin_lsn) {
+          checkpoint_pages.insert(log_record.GetDirtyPageTable().begin(), log_record.GetDirtyPageTable().end());
+        }
+        break;
+      case LogRecordType::END_CHECKPOINT:
+        if (log_record.GetPrevLSN() != begin_lsn) {
+          break;
+        }
+        has_checkpoint_ = true;
+        dirty_page_table_ = std::move(checkpoint_pages);
+        dirty_page_table_.insert(log_record.GetDirtyPageTable().begin(), log_record.GetDirtyPageTable().end());
+        checkpoint_pages.clear();
+        for (const auto &[page_id, first_lsn] : changed_since_begin) {
+          auto [iter, inserted] = dirty_page_table_.emplace(page_id, first_lsn);
+          if (!inserted) {
+            iter->second = std::min(iter->second, first_lsn);
+          }
+        }
+        break;
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        active_txn_.erase(log_record.GetTxnId());
+        break;
+      default: {
+        active_txn_[log_record.GetTxnId()] = lsn;
+        auto [page_id, prev_page_id] = ChangedPages(&log_record);
+        for (page_id_t changed : {page_id, prev_page_id}) {
+          if (changed == INVALID_PAGE_ID) {
+            continue;
+          }
+          changed_since_begin.emplace(changed, lsn);
+          if (has_checkpoint_) {
+            dirty_page_table_.emplace(changed, lsn);
+          }
+        }
+        break;
+      }
+    }
+  }
+}
+
+bool LogRecovery::NeedsRedo(LogRecord *log_record, page_id_t page_id) {
+  if (!has_checkpoint_) {
+    return true;
+  }
+  auto iter = dirty_page_table_.find(page_id);
+  return iter != dirty_page_table_.end() && log_record->GetLSN() >= iter->second;
+}
+
+void LogRecovery::RedoLogRecord(LogRecord *log_record, page_id_t page_id) {
+  lsn_t lsn = log_record->GetLSN();
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  BUSTUB_ASSERT(static_cast<bool>(guard), "Recovery needs a frame for every page it redoes.");
+
+  // The link from the page before a new one is set again whenever it is missing, it has no LSN of its own to compare.
+  if (log_record->GetLogRecordType() == LogRecordType::NEWPAGE && page_id == log_record->GetNewPageRecord()) {
+    if (guard.As<TablePage>()->GetNextPageId() != log_record->GetNewPageId()) {
+      guard.AsMut<TablePage>()->SetNextPageId(log_record->GetNewPageId());
+    }
+    return;
+  }
+  if (guard.As<TablePage>()->GetLSN() >= lsn) {
+    return;
+  }
+  auto *page = guard.AsMut<TablePage>();
+  RID rid;
+  Tuple old_tuple;
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::INSERT:
+      page->InsertTuple(log_record->GetInsertTuple(), &rid, nullptr, nullptr, nullptr);
+      BUSTUB_ASSERT(rid == log_record->GetInsertRID(), "Redo must insert the tuple where it was inserted.");
+      break;
+    case LogRecordType::MARKDELETE:
+      page->MarkDelete(log_record->GetDeleteRID(), nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->ApplyDelete(log_record->GetDeleteRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->RollbackDelete(log_record->GetDeleteRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE:
+      page->UpdateTuple(log_record->GetUpdateTuple(), &old_tuple, log_record->GetUpdateRID(), nullptr, nullptr,
+                        nullptr);
+      break;
+    case LogRecordType::NEWPAGE:
+      page->Init(page_id, PAGE_SIZE, log_record->GetNewPageRecord(), nullptr, nullptr);
+      break;
+    default:
+      break;
+  }
+  page->SetLSN(lsn);
+  num_redone_++;
+}
+
+void LogRecovery::UndoLogRecord(LogRecord *log_record) {
+  auto [page_id, prev_page_id] = ChangedPages(log_record);
+  // A new page stays in the table, empty once the inserts into it are undone.
+  if (page_id == INVALID_PAGE_ID || log_record->GetLogRecordType() == LogRecordType::NEWPAGE) {
+    return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  BUSTUB_ASSERT(static_cast<bool>(guard), "Recovery needs a frame for every page it undoes.");
+  auto *page = guard.AsMut<TablePage>();
+  RID rid;
+  Tuple new_tuple;
+  switch (log_record->GetLogRecordType()) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record->GetInsertRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record->GetDeleteRID(), nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->InsertTuple(log_record->GetDeleteTuple(), &rid, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record->GetDeleteRID(), nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE:
+      page->UpdateTuple(log_record->GetOriginalTuple(), &new_tuple, log_record->GetUpdateRID(), nullptr, nullptr,
+                        nullptr);
+      break;
+    default:
+      break;
+  }
+}
 
 }  // namespace bustub
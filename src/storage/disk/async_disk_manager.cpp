@@ -0,0 +1,381 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+AsyncDiskManager::AsyncDiskManager(const std::string &db_file, size_t queue_depth, bool direct_io)
+    : DiskManager(db_file, direct_io) {
+  if (!SetUpRing(static_cast<unsigned>(queue_depth))) {
+    LOG_DEBUG("io_uring is not available, falling back to synchronous I/O");
+    return;
+  }
+  reaper_thread_ = std::thread(&AsyncDiskManager::RunReaper, this);
+}
+
+AsyncDiskManager::~AsyncDiskManager() { TearDownRing(); }
+
+void AsyncDiskManager::ShutDown() {
+  TearDownRing();
+  DiskManager::ShutDown();
+}
+
+void AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  WritePageAsync(page_id, page_data).wait();
+}
+
+void AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data) { ReadPageAsync(page_id, page_data).wait(); }
+
+void AsyncDiskManager::WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) {
+  if (!IsUringEnabled()) {
+    DiskManager::WritePages(page_ids, page_data);
+    return;
+  }
+  WriteExtentHeaders();
+  std::vector<Request *> requests;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    requests.push_back(MakeRequest(true, page_ids[i], const_cast<char *>(page_data[i])));
+  }
+  SubmitAndWait(requests);
+}
+
+void AsyncDiskManager::ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) {
+  if (!IsUringEnabled()) {
+    DiskManager::ReadPages(page_ids, page_data);
+    return;
+  }
+  std::vector<Request *> requests;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    requests.push_back(MakeRequest(false, page_ids[i], page_data[i]));
+  }
+  SubmitAndWait(requests);
+}
+
+std::future<void> AsyncDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  if (!IsUringEnabled()) {
+    std::promise<void> promise;
+    DiskManager::WritePage(page_id, page_data);
+    promise.set_value();
+    return promise.get_future();
+  }
+  WriteExtentHeaders();
+  Request *request = MakeRequest(true, page_id, const_cast<char *>(page_data));
+  std::future<void> future = request->promise_.get_future();
+  Submit({request});
+  return future;
+}
+
+std::future<void> AsyncDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (!IsUringEnabled()) {
+    std::promise<void> promise;
+    DiskManager::ReadPage(page_id, page_data);
+    promise.set_value();
+    return promise.get_future();
+  }
+  Request *request = MakeRequest(false, page_id, page_data);
+  std::future<void> future = request->promise_.get_future();
+  Submit({request});
+  return future;
+}
+
+bool AsyncDiskManager::RegisterBuffers(char *data, size_t size) {
+  if (!IsUringEnabled() || size == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto same_start = [data](const iovec &buffer) { return buffer.iov_base == data; };
+  buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), same_start), buffers_.end());
+  std::vector<iovec> registered = buffers_;
+  buffers_.push_back(iovec{data, size});
+  if (UpdateBuffers()) {
+    return true;
+  }
+  // Most likely the range is more than the kernel lets this process lock, keep the ranges that fit.
+  buffers_ = registered;
+  UpdateBuffers();
+  return false;
+}
+
+void AsyncDiskManager::UnregisterBuffers(char *data) {
+  if (!IsUringEnabled()) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto same_start = [data](const iovec &buffer) { return buffer.iov_base == data; };
+  auto end = std::remove_if(buffers_.begin(), buffers_.end(), same_start);
+  if (end != buffers_.end()) {
+    buffers_.erase(end, buffers_.end());
+    UpdateBuffers();
+  }
+}
+
+bool AsyncDiskManager::SetUpRing(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd_ < 0) {
+    return false;
+  }
+
+  // The submission and completion rings share one mapping on kernels that support it.
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  void *sq_ring =
+      mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  sq_ring_ = sq_ring;
+  void *cq_ring = single_mmap ? sq_ring_
+                              : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                     ring_fd_, IORING_OFF_CQ_RING);
+  if (cq_ring == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  cq_ring_ = cq_ring;
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  queue_depth_ = std::min(entries, params.sq_entries);
+  return true;
+}
+
+void AsyncDiskManager::TearDownRing() {
+  if (reaper_thread_.joinable()) {
+    std::unique_lock<std::mutex> lock(latch_);
+    in_flight_cv_.wait(lock, [this] { return in_flight_ == 0; });
+    Prepare(nullptr);
+    Enter(1);
+    lock.unlock();
+    reaper_thread_.join();
+  }
+  // Closing the ring also drops the registered buffers.
+  buffers_.clear();
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+AsyncDiskManager::Request *AsyncDiskManager::MakeRequest(bool is_write, page_id_t page_id, char *data) {
+  auto *request = new Request{is_write, page_id, data, nullptr, {}};
+  if (direct_io_ && !IsAligned(data)) {
+    request->bounce_ = AllocateAligned(PAGE_SIZE);
+    if (is_write) {
+      memcpy(request->bounce_, data, PAGE_SIZE);
+    }
+  }
+  return request;
+}
+
+void AsyncDiskManager::SubmitAndWait(const std::vector<Request *> &requests) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(requests.size());
+  for (Request *request : requests) {
+    futures.push_back(request->promise_.get_future());
+  }
+  Submit(requests);
+  for (auto &future : futures) {
+    future.wait();
+  }
+}
+
+void AsyncDiskManager::Submit(const std::vector<Request *> &requests) {
+  // Every request that is prepared counts as in flight, so the submission queue never holds more entries than it has.
+  // Whenever the queue depth is reached, hand what is prepared to the kernel and wait for completions.
+  std::unique_lock<std::mutex> lock(latch_);
+  unsigned num_prepared = 0;
+  for (Request *request : requests) {
+    if (in_flight_ >= queue_depth_) {
+      if (num_prepared > 0) {
+        Enter(num_prepared);
+        num_prepared = 0;
+      }
+      in_flight_cv_.wait(lock, [this] { return in_flight_ < queue_depth_; });
+    }
+    if (request->is_write_) {
+      num_writes_ += 1;
+    } else {
+      num_reads_ += 1;
+    }
+    Prepare(request);
+    in_flight_++;
+    num_prepared++;
+  }
+  if (num_prepared > 0) {
+    Enter(num_prepared);
+  }
+}
+
+void AsyncDiskManager::Prepare(Request *request) {
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = sqes_ + index;
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    auto address = reinterpret_cast<uintptr_t>(request->bounce_ != nullptr ? request->bounce_ : request->data_);
+    for (size_t i = 0; i < buffers_.size(); i++) {
+      auto start = reinterpret_cast<uintptr_t>(buffers_[i].iov_base);
+      if (address >= start && address + PAGE_SIZE <= start + buffers_[i].iov_len) {
+        sqe->opcode = request->is_write_ ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = static_cast<uint16_t>(i);
+        break;
+      }
+    }
+    sqe->fd = db_fd_;
+    sqe->off = static_cast<uint64_t>(PageOffset(request->page_id_));
+    sqe->addr = address;
+    sqe->len = PAGE_SIZE;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+  }
+  sq_array_[index] = index;
+  // The kernel reads the entry once it sees the new tail.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+void AsyncDiskManager::Enter(unsigned to_submit) {
+  while (to_submit > 0) {
+    int rc = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr, 0));
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      throw Exception("io_uring_enter failed: " + std::string(strerror(errno)));
+    }
+    to_submit -= rc;
+  }
+}
+
+bool AsyncDiskManager::UpdateBuffers() {
+  // Unregistering fails if nothing is registered, which is fine.
+  syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+  if (buffers_.empty()) {
+    return true;
+  }
+  if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, buffers_.data(), buffers_.size()) < 0) {
+    buffers_.clear();
+    return false;
+  }
+  return true;
+}
+
+void AsyncDiskManager::RunReaper() {
+  while (true) {
+    syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    // Only this thread moves the head, the kernel publishes new entries by moving the tail.
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned num_completed = 0;
+    bool stop = false;
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = cqes_ + (head & *cq_mask_);
+      auto *request = reinterpret_cast<Request *>(cqe->user_data);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      Complete(request, cqe->res);
+      num_completed++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (num_completed > 0) {
+      {
+        std::lock_guard<std::mutex> guard(latch_);
+        in_flight_ -= num_completed;
+      }
+      in_flight_cv_.notify_all();
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void AsyncDiskManager::Complete(Request *request, int result) {
+  off_t offset = PageOffset(request->page_id_);
+  char *data = request->bounce_ != nullptr ? request->bounce_ : request->data_;
+  if (result >= 0 && request->is_write_) {
+    ExtendFileSize(offset + result);
+  }
+  if (result < 0) {
+    LOG_DEBUG("I/O error while %s: %s", request->is_write_ ? "writing" : "reading", strerror(-result));
+  } else if (result < PAGE_SIZE) {
+    // A short transfer is rare, finish it synchronously. A read at the end of the file comes back short, the rest of
+    // the page reads as zeros.
+    if (request->is_write_) {
+      if (!WriteAt(data + result, PAGE_SIZE - result, offset + result)) {
+        LOG_DEBUG("I/O error while writing");
+      }
+    } else {
+      size_t read_count = result + ReadAt(data + result, PAGE_SIZE - result, offset + result);
+      memset(data + read_count, 0, PAGE_SIZE - read_count);
+    }
+  }
+  if (request->bounce_ != nullptr) {
+    if (!request->is_write_) {
+      memcpy(request->data_, request->bounce_, PAGE_SIZE);
+    }
+    free(request->bounce_);
+  }
+  request->promise_.set_value();
+  delete request;
+}
+
+}  // namespace bustub
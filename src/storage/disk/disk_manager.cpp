@@ -10,8 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -25,12 +32,24 @@ namespace bustub {
 
 static char *buffer_used;
 
+// An extent header page starts with this magic number and the number of its extent, followed by the bitmap.
+static constexpr uint32_t EXTENT_HEADER_MAGIC = 0x42545845;
+static constexpr size_t EXTENT_BITMAP_OFFSET = 2 * sizeof(uint32_t);
+static_assert(DISK_EXTENT_SIZE % 8 == 0, "an extent bitmap must be whole bytes");
+static_assert(EXTENT_BITMAP_OFFSET + DISK_EXTENT_SIZE / 8 <= PAGE_SIZE, "an extent bitmap must fit into one page");
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : file_name_(db_file),
+      next_page_id_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      num_reads_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -38,90 +57,153 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
-
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // the log is only ever appended to, and read back with pread
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
+
+  // create the file if it does not exist
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_WARN("direct I/O is not supported for %s, falling back to buffered I/O", db_file.c_str());
     }
   }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
   buffer_used = nullptr;
+  file_size_ = std::max<off_t>(GetFileSize(file_name_), 0);
+  LoadExtents();
+}
+
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    WriteExtentHeaders();
+    close(db_fd_);
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  if (db_fd_ >= 0) {
+    WriteExtentHeaders();
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
+ * pwrite takes the offset with it and goes straight to the kernel, so there is no cursor to share and nothing to flush
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  WriteExtentHeaders();
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
   // check for I/O error
-  if (db_io_.bad()) {
+  if (!WriteAt(page_data, PAGE_SIZE, PageOffset(page_id))) {
     LOG_DEBUG("I/O error while writing");
-    return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  off_t offset = PageOffset(page_id);
+  // check if read beyond file length, the size is kept in memory so that a read does not stat the file
+  if (offset > file_size_) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
+    // A page that never reached disk, as recovery reads after a crash, reads as zeros like a page of a sparse file.
+    memset(page_data, 0, PAGE_SIZE);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
-    }
+    num_reads_ += 1;
+    size_t read_count = ReadAt(page_data, PAGE_SIZE, offset);
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    if (read_count < static_cast<size_t>(PAGE_SIZE)) {
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
       memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
   }
 }
 
+/**
+ * Write a batch of pages in page id order, coalescing runs of adjacent pages into one pwritev each
+ * Pages of different extents are never adjacent in the file, the header of the later extent lies between them
+ */
+void DiskManager::WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) {
+  WriteExtentHeaders();
+  std::vector<size_t> order(page_ids.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  // A stable sort keeps the writes of a page that is in the batch twice in the order they were given.
+  std::stable_sort(order.begin(), order.end(), [&page_ids](size_t a, size_t b) { return page_ids[a] < page_ids[b]; });
+  size_t run_begin = 0;
+  while (run_begin < order.size()) {
+    page_id_t first_page_id = page_ids[order[run_begin]];
+    size_t run_end = run_begin + 1;
+    while (run_end < order.size() && run_end - run_begin < static_cast<size_t>(IOV_MAX) &&
+           page_ids[order[run_end]] == first_page_id + static_cast<page_id_t>(run_end - run_begin) &&
+           page_ids[order[run_end]] % DISK_EXTENT_SIZE != 0) {
+      run_end++;
+    }
+    std::vector<iovec> buffers;
+    bool aligned = true;
+    for (size_t i = run_begin; i < run_end; i++) {
+      const char *data = page_data[order[i]];
+      aligned = aligned && IsAligned(data);
+      buffers.push_back(iovec{const_cast<char *>(data), static_cast<size_t>(PAGE_SIZE)});
+    }
+    if (buffers.size() == 1 || (direct_io_ && !aligned)) {
+      // Direct I/O needs every buffer aligned, WritePage copies the ones that are not.
+      for (size_t i = run_begin; i < run_end; i++) {
+        WritePage(page_ids[order[i]], page_data[order[i]]);
+      }
+    } else {
+      num_writes_ += buffers.size();
+      if (!WriteVAt(std::move(buffers), PageOffset(first_page_id))) {
+        LOG_DEBUG("I/O error while writing");
+      }
+    }
+    run_begin = run_end;
+  }
+}
+
+/**
+ * Flush the kernel's copy of the db file to disk, the metadata only as far as needed to read the data back
+ */
+void DiskManager::Sync() {
+  WriteExtentHeaders();
+  num_syncs_ += 1;
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+  }
+}
+
+/**
+ * Read a batch of pages one after another
+ */
+void DiskManager::ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) {
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    ReadPage(page_ids[i], page_data[i]);
+  }
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -143,16 +225,23 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
+  // sequence write, the file is opened with O_APPEND
+  for (int written = 0; written < size;) {
+    ssize_t n = write(log_fd_, log_data + written, size - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    written += n;
+  }
+  // the records are only durable once they are on the device, not just in the page cache
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -167,17 +256,23 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
-    return false;
+  int read_count = 0;
+  while (read_count < size) {
+    ssize_t n = pread(log_fd_, log_data + read_count, size - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading log");
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
@@ -186,16 +281,60 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Take the lowest free page with the given stride and offset, and grow the file by an extent if there is none
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t offset) {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  // 1.   Start at the lowest page id that may be free for this stride and offset.
+  // 2.   Step over allocated pages, adding extents once the search runs past the end of the file.
+  // 3.   Mark the page allocated and its extent header dirty, and remember where the next search starts.
+  uint64_t key = (static_cast<uint64_t>(stride) << 32) | offset;
+  auto hint = alloc_hints_.find(key);
+  auto page_id = static_cast<page_id_t>(hint != alloc_hints_.end() ? hint->second : offset);
+  while (true) {
+    while (static_cast<size_t>(page_id) >= page_bitmap_.size() * 8) {
+      AddExtent();
+    }
+    if (!IsAllocated(page_id)) {
+      break;
+    }
+    page_id += stride;
+  }
+  page_bitmap_[page_id / 8] |= 1 << (page_id % 8);
+  dirty_extents_.insert(page_id / DISK_EXTENT_SIZE);
+  extents_dirty_ = true;
+  alloc_hints_[key] = page_id + stride;
+  if (page_id >= next_page_id_) {
+    next_page_id_ = page_id + 1;
+  }
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * Clear the page in the bitmap, the next allocation with a matching stride and offset may take it
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  if (page_id < 0 || static_cast<size_t>(page_id) >= page_bitmap_.size() * 8 || !IsAllocated(page_id)) {
+    return;
+  }
+  page_bitmap_[page_id / 8] &= ~(1 << (page_id % 8));
+  dirty_extents_.insert(page_id / DISK_EXTENT_SIZE);
+  extents_dirty_ = true;
+  for (auto &[key, hint] : alloc_hints_) {
+    auto stride = static_cast<uint32_t>(key >> 32);
+    auto offset = static_cast<uint32_t>(key);
+    if (page_id < hint && static_cast<uint32_t>(page_id) % stride == offset % stride) {
+      hint = page_id;
+    }
+  }
+  page_id_t next_page_id = next_page_id_;
+  while (next_page_id > 0 && !IsAllocated(next_page_id - 1)) {
+    next_page_id--;
+  }
+  next_page_id_ = next_page_id;
+}
 
 /**
  * Returns number of flushes made so far
@@ -207,18 +346,236 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 int DiskManager::GetNumWrites() const { return num_writes_; }
 
+/**
+ * Returns number of Reads made so far
+ */
+int DiskManager::GetNumReads() const { return num_reads_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Write with pwrite until the whole buffer is written
+ */
+bool DiskManager::WriteAt(const char *data, size_t size, off_t offset) {
+  if (direct_io_ && !IsAligned(data)) {
+    char *aligned = AllocateAligned(size);
+    memcpy(aligned, data, size);
+    bool written = WriteAt(aligned, size, offset);
+    free(aligned);
+    return written;
+  }
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(db_fd_, data + written, size - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    written += rc;
+  }
+  ExtendFileSize(offset + static_cast<off_t>(size));
+  return true;
+}
+
+/**
+ * Write with pwritev until all buffers are written
+ */
+bool DiskManager::WriteVAt(std::vector<iovec> buffers, off_t offset) {
+  size_t index = 0;
+  while (index < buffers.size()) {
+    ssize_t rc = pwritev(db_fd_, buffers.data() + index, static_cast<int>(buffers.size() - index), offset);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    offset += rc;
+    // Skip what was written, a short write may end in the middle of a buffer.
+    auto remaining = static_cast<size_t>(rc);
+    while (remaining > 0 && remaining >= buffers[index].iov_len) {
+      remaining -= buffers[index].iov_len;
+      index++;
+    }
+    if (remaining > 0) {
+      buffers[index].iov_base = static_cast<char *>(buffers[index].iov_base) + remaining;
+      buffers[index].iov_len -= remaining;
+    }
+  }
+  ExtendFileSize(offset);
+  return true;
+}
+
+/**
+ * Read with pread until the buffer is full or the file ends
+ */
+size_t DiskManager::ReadAt(char *data, size_t size, off_t offset) {
+  if (direct_io_ && !IsAligned(data)) {
+    char *aligned = AllocateAligned(size);
+    size_t read_count = ReadAt(aligned, size, offset);
+    memcpy(data, aligned, read_count);
+    free(aligned);
+    return read_count;
+  }
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(db_fd_, data + read_count, size - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG_DEBUG("I/O error while reading");
+      break;
+    }
+    // the file ends here
+    if (rc == 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  return read_count;
+}
+
+/**
+ * Allocate a buffer that direct I/O accepts
+ */
+char *DiskManager::AllocateAligned(size_t size) {
+  // aligned_alloc wants a multiple of the alignment
+  size_t rounded = (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+  auto *data = static_cast<char *>(aligned_alloc(PAGE_SIZE, rounded));
+  if (data == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate an aligned I/O buffer");
+  }
+  return data;
+}
+
+/**
+ * Rebuild the free-space bitmap from the extent headers on disk
+ * An extent without a valid header was written before its header or lost it, all of its pages that are in the file
+ * count as allocated so that none of them is handed out twice
+ */
+void DiskManager::LoadExtents() {
+  off_t file_size = file_size_;
+  const off_t extent_bytes = static_cast<off_t>(DISK_EXTENT_SIZE + 1) * PAGE_SIZE;
+  size_t num_extents = file_size > 0 ? (file_size + extent_bytes - 1) / extent_bytes : 0;
+  page_bitmap_.assign(num_extents * DISK_EXTENT_SIZE / 8, 0);
+  char header[PAGE_SIZE];
+  for (size_t extent = 0; extent < num_extents; extent++) {
+    size_t read_count = ReadAt(header, PAGE_SIZE, ExtentOffset(extent));
+    uint32_t magic = 0;
+    uint32_t number = 0;
+    if (read_count == static_cast<size_t>(PAGE_SIZE)) {
+      memcpy(&magic, header, sizeof(magic));
+      memcpy(&number, header + sizeof(magic), sizeof(number));
+    }
+    uint8_t *bitmap = page_bitmap_.data() + extent * DISK_EXTENT_SIZE / 8;
+    if (magic == EXTENT_HEADER_MAGIC && number == extent) {
+      memcpy(bitmap, header + EXTENT_BITMAP_OFFSET, DISK_EXTENT_SIZE / 8);
+      continue;
+    }
+    auto first_page_id = static_cast<page_id_t>(extent * DISK_EXTENT_SIZE);
+    for (page_id_t page_id = first_page_id; page_id < first_page_id + DISK_EXTENT_SIZE; page_id++) {
+      if (PageOffset(page_id) < file_size) {
+        page_bitmap_[page_id / 8] |= 1 << (page_id % 8);
+      }
+    }
+  }
+  page_id_t next_page_id = static_cast<page_id_t>(page_bitmap_.size() * 8);
+  while (next_page_id > 0 && !IsAllocated(next_page_id - 1)) {
+    next_page_id--;
+  }
+  next_page_id_ = next_page_id;
+  num_preallocated_extents_ = num_extents;
+}
+
+/**
+ * Grow the bitmap by one extent, its header is written with the other dirty ones
+ */
+void DiskManager::AddExtent() {
+  size_t extent = page_bitmap_.size() * 8 / DISK_EXTENT_SIZE;
+  page_bitmap_.resize(page_bitmap_.size() + DISK_EXTENT_SIZE / 8, 0);
+  dirty_extents_.insert(extent);
+  extents_dirty_ = true;
+}
+
+/**
+ * Fill an extent header page: the magic number, the number of the extent and its part of the bitmap
+ */
+void DiskManager::BuildExtentHeader(size_t extent, char *header) const {
+  memset(header, 0, PAGE_SIZE);
+  auto number = static_cast<uint32_t>(extent);
+  memcpy(header, &EXTENT_HEADER_MAGIC, sizeof(EXTENT_HEADER_MAGIC));
+  memcpy(header + sizeof(EXTENT_HEADER_MAGIC), &number, sizeof(number));
+  memcpy(header + EXTENT_BITMAP_OFFSET, page_bitmap_.data() + extent * DISK_EXTENT_SIZE / 8, DISK_EXTENT_SIZE / 8);
+}
+
+/**
+ * Reserve the space of new extents in the file and write the extent header pages that changed, they do not count as
+ * page writes
+ * KEEP_SIZE leaves the file size alone, so reads of pages that were never written still find the end of the file
+ */
+void DiskManager::WriteExtentHeaders() {
+  if (!extents_dirty_) {
+    return;
+  }
+  std::lock_guard<std::mutex> io_guard(extent_io_latch_);
+  // 1.   Copy the dirty headers under alloc_latch_, allocations go on while they are written.
+  // 2.   Preallocate the extents that were added, then write the headers without alloc_latch_.
+  // 3.   Clear the flag only if nothing got dirty meanwhile, so a page write that sees it clear knows that its
+  //      allocation is on disk, even if another thread took the header to write it.
+  std::vector<size_t> extents;
+  std::vector<char> headers;
+  size_t num_extents;
+  {
+    std::lock_guard<std::mutex> guard(alloc_latch_);
+    extents.assign(dirty_extents_.begin(), dirty_extents_.end());
+    dirty_extents_.clear();
+    headers.resize(extents.size() * PAGE_SIZE);
+    for (size_t i = 0; i < extents.size(); i++) {
+      BuildExtentHeader(extents[i], headers.data() + i * PAGE_SIZE);
+    }
+    num_extents = page_bitmap_.size() * 8 / DISK_EXTENT_SIZE;
+  }
+  // Preallocation is only a hint to the file system, a file system without fallocate grows the file on write.
+  if (num_preallocated_extents_ < num_extents) {
+    off_t begin = ExtentOffset(num_preallocated_extents_);
+    if (fallocate(db_fd_, FALLOC_FL_KEEP_SIZE, begin, ExtentOffset(num_extents) - begin) != 0) {
+      LOG_DEBUG("fallocate failed: %s", strerror(errno));
+    }
+    num_preallocated_extents_ = num_extents;
+  }
+  for (size_t i = 0; i < extents.size(); i++) {
+    if (!WriteAt(headers.data() + i * PAGE_SIZE, PAGE_SIZE, ExtentOffset(extents[i]))) {
+      LOG_DEBUG("I/O error while writing an extent header");
+    }
+  }
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  if (dirty_extents_.empty()) {
+    extents_dirty_ = false;
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+off_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? stat_buf.st_size : -1;
+}
+
+/**
+ * Raise the cached size of the db file to cover a write that ended at the given offset
+ */
+void DiskManager::ExtendFileSize(off_t end) {
+  off_t file_size = file_size_;
+  while (file_size < end && !file_size_.compare_exchange_weak(file_size, end)) {
+  }
 }
 
 }  // namespace bustub
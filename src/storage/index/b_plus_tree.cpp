@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -54,16 +55,23 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   if (root_page_id_ == INVALID_PAGE_ID) {
     return false;
   }
-  Page *leaf_page;
-  bool *is_root_lock;
+  // Point lookups first try to get by without latching the inner pages, most of the time no writer is in the way.
+  ReadPageGuard optimistic_leaf_guard = FindLeafPageOptimistic(key);
+  if (optimistic_leaf_guard) {
+    ValueType value{};
+    bool is_exist = optimistic_leaf_guard.As<LeafPage>()->Lookup(key, &value, comparator_);
+    if (is_exist) {
+      result->push_back(value);
+    }
+    return is_exist;
+  }
+  // Fall back to latch crabbing. It needs a page set to release the pages through, so a caller without a transaction
+  // gets a local one.
+  Transaction local_transaction(INVALID_TXN_ID);
   if (transaction == nullptr) {
-    // LOG_INFO("Enter nullptr");
-    leaf_page = FindLeafPage(key, false);
-  } else {
-    auto ret_value = FindLeafPageByOperation(key, OperationType::FIND, transaction, false);
-    leaf_page = ret_value.first;
-    is_root_lock = ret_value.second;
+    transaction = &local_transaction;
   }
+  auto [leaf_page, is_root_lock] = FindLeafPageByOperation(key, OperationType::FIND, transaction, false);
   // LOG_INFO("Enter Function GetValue");
   // LOG_INFO("leaf page id is : %d", leaf_page->GetPageId());
   LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
@@ -73,15 +81,9 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   if (is_exist) {
     result->push_back(value);
   }
-  if (transaction == nullptr) {
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-  } else {
-    UnlatchAndUnpin(transaction, OperationType::FIND);
-  }
+  UnlatchAndUnpin(transaction, OperationType::FIND);
   // LOG_INFO("End Function GetValue");
-  if (transaction != nullptr) {
-    delete is_root_lock;
-  }
+  delete is_root_lock;
   return is_exist;
 }
 
@@ -122,17 +124,16 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
   page_id_t new_page_id = INVALID_PAGE_ID;
-  Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
-  if (new_page == nullptr) {
+  BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id);
+  if (!new_guard) {
     throw std::runtime_error("out of memory");
   }
-  root_page_id_ = new_page_id;
-  UpdateRootPageId(1);
-
-  LeafPage *new_node = reinterpret_cast<LeafPage *>(new_page->GetData());
+  LeafPage *new_node = new_guard.AsMut<LeafPage>();
   new_node->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);
   new_node->Insert(key, value, comparator_);
-  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  // Publish the root only once it is filled in, optimistic readers may pick it up right away.
+  root_page_id_ = new_page_id;
+  UpdateRootPageId(1);
 }
 
 /*
@@ -169,11 +170,11 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
   int current_size = leaf_node->Insert(key, value, comparator_);
   // 溢出，进行split
   if (current_size == leaf_node->GetMaxSize()) {
-    LeafPage *new_leaf_node = Split<LeafPage>(leaf_node);
+    BasicPageGuard new_leaf_guard = Split<LeafPage>(leaf_node);
+    LeafPage *new_leaf_node = new_leaf_guard.As<LeafPage>();
     // LOG_INFO("Insert key %ld in leaf page %d result out new page %d", key.ToString(), leaf_node->GetPageId(),
     // new_leaf_node->GetPageId()); InsertIntoParent(leaf_node, new_leaf_node->KeyAt(0), new_leaf_node, transaction);
     InsertIntoParent(leaf_node, new_leaf_node->KeyAt(0), new_leaf_node, transaction, is_root_lock);
-    buffer_pool_manager_->UnpinPage(new_leaf_node->GetPageId(), true);
     // LOG_INFO("the is_root_lock is : %d", is_root_lock);
     assert(*is_root_lock == false);
   }
@@ -197,15 +198,15 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-N *BPLUSTREE_TYPE::Split(N *node) {
+BasicPageGuard BPLUSTREE_TYPE::Split(N *node) {
   page_id_t new_page_id = INVALID_PAGE_ID;
-  Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
-  if (new_page == nullptr) {
+  BasicPageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id);
+  if (!new_guard) {
     // throw std::runtime_error("out of memory");
     throw std::runtime_error("out of memory in Split");
   }
 
-  N *new_node = reinterpret_cast<N *>(new_page->GetData());
+  N *new_node = new_guard.AsMut<N>();
   new_node->Init(new_page_id, node->GetParentPageId(), node->GetMaxSize());
   // new_node->SetPageType(node->GetPageType());
   // 编译的时候函数内部只看得到类型N，运行的时候才能确定是什么类型
@@ -223,7 +224,7 @@ N *BPLUSTREE_TYPE::Split(N *node) {
     InternalPage *new_inter_node = reinterpret_cast<InternalPage *>(new_node);
     old_inter_node->MoveHalfTo(new_inter_node, buffer_pool_manager_);
   }
-  return new_node;
+  return new_guard;
 }
 
 // 分裂后将指向新page的key和value存到父节点中
@@ -247,32 +248,34 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
     // B+ tree metadata
     // std::lock_guard<std::mutex> guard(root_latch_);
     page_id_t new_root_page_id = INVALID_PAGE_ID;
-    Page *new_root_page = buffer_pool_manager_->NewPage(&new_root_page_id);
-    if (new_root_page == nullptr) {
+    BasicPageGuard new_root_guard = buffer_pool_manager_->NewPageGuarded(&new_root_page_id);
+    if (!new_root_guard) {
       throw std::runtime_error("out of memory in InsertIntoParent");
     }
-    root_page_id_ = new_root_page_id;
-    UpdateRootPageId(0);
     // root node metadata
-    InternalPage *new_root_node = reinterpret_cast<InternalPage *>(new_root_page->GetData());
+    InternalPage *new_root_node = new_root_guard.AsMut<InternalPage>();
     new_root_node->Init(new_root_page_id, INVALID_PAGE_ID, internal_max_size_);
     new_root_node->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
     // child node metadata
     old_node->SetParentPageId(new_root_page_id);
     new_node->SetParentPageId(new_root_page_id);
+    // Publish the new root only once it is filled in, optimistic readers may pick it up right away.
+    root_page_id_ = new_root_page_id;
+    UpdateRootPageId(0);
     // 处理结束，释放新的根节点
     if (*is_root_lock) {
       *is_root_lock = false;
       root_latch_.unlock();
     }
-    buffer_pool_manager_->UnpinPage(new_root_page_id, true);
     // LOG_INFO("End InsertIntoParent, the key is %ld ", key.ToString());
     return;
   }
 
   page_id_t parent_page_id = old_node->GetParentPageId();
   // 这里parent_page已经在transaction的set里
-  Page *parent_page = buffer_pool_manager_->FetchPage(parent_page_id);
+  // A node that splits was not safe, so the descent kept its parent latched and pinned in the page set.
+  Page *parent_page = GetLatchedPage(transaction, parent_page_id);
+  assert(parent_page != nullptr);
   InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
   int parent_current_size = parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
   // LOG_INFO("The parent node's size is %d", parent_current_size);
@@ -280,10 +283,10 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
   // parent_current_size == parent_node->GetMaxSize()
   if (parent_current_size == internal_max_size_ + 1) {
     // LOG_INFO("current size is %d, max size is %d", parent_current_size, internal_max_size_);
-    InternalPage *split_node = Split<InternalPage>(parent_node);
+    BasicPageGuard split_guard = Split<InternalPage>(parent_node);
+    InternalPage *split_node = split_guard.As<InternalPage>();
     KeyType new_parent_key = split_node->KeyAt(0);
     InsertIntoParent(parent_node, new_parent_key, split_node, transaction, is_root_lock);
-    buffer_pool_manager_->UnpinPage(split_node->GetPageId(), true);
   }
   if (*is_root_lock) {
     *is_root_lock = false;
@@ -363,24 +366,20 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, b
     return false;
   }
 
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
+  // A node that underflows was not safe, so the descent kept its parent latched and pinned in the page set.
+  Page *parent_page = GetLatchedPage(transaction, node->GetParentPageId());
+  assert(parent_page != nullptr);
   InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
   int node_index = parent_node->ValueIndex(node->GetPageId());
 
-  Page *neighbor_page;
-  if (node_index == 0) {
-    neighbor_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(1));
-  } else {
-    neighbor_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(node_index - 1));
-  }
-  neighbor_page->WLatch();
-  transaction->AddIntoPageSet(neighbor_page);
-
-  N *neighbor_node = reinterpret_cast<N *>(neighbor_page->GetData());
+  // No other writer gets to the sibling while the parent stays latched, so it is released once this level is done.
+  WritePageGuard neighbor_guard =
+      buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(node_index == 0 ? 1 : node_index - 1));
+  N *neighbor_node = neighbor_guard.AsMut<N>();
 
   if (neighbor_node->GetSize() + node->GetSize() >= node->GetMaxSize()) {
     // 重新分配
-    Redistribute(neighbor_node, node, node_index);
+    Redistribute(neighbor_node, node, parent_node, node_index);
     // UnlatchAndUnpin(transaction, OperationType::DELETE);
     // buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
     // buffer_pool_manager_->UnpinPage(neighbor_node->GetPageId(), true);
@@ -399,6 +398,11 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, b
     transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
     // buffer_pool_manager_->DeletePage(parent_node->GetPageId());
   }
+  if (node_index == 0) {
+    // Coalesce moved the right sibling into the leftmost child, so the sibling is the page that goes away.
+    transaction->AddIntoDeletedPageSet(neighbor_guard.PageId());
+    return false;
+  }
   // UnlatchAndUnpin(transaction, OperationType::DELETE);
   // buffer_pool_manager_->UnpinPage(neighbor_node->GetPageId(), true);
   // buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
@@ -456,13 +460,11 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent_node        parent page of both, latched by the caller
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent_node, int index) {
   if (node->IsLeafPage()) {
     LeafPage *leaf_neighbor_node = reinterpret_cast<LeafPage *>(neighbor_node);
     LeafPage *leaf_current_node = reinterpret_cast<LeafPage *>(node);
@@ -488,8 +490,6 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
       parent_node->SetKeyAt(index, internal_current_node->KeyAt(0));
     }
   }
-
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
 }
 
 /*
@@ -518,12 +518,10 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
     if (old_root_node->GetSize() == 1) {
       InternalPage *old_internal_node = reinterpret_cast<InternalPage *>(old_root_node);
       page_id_t new_root_page_id = old_internal_node->RemoveAndReturnOnlyChild();
-      Page *new_root_page = buffer_pool_manager_->FetchPage(new_root_page_id);
-      LeafPage *new_root_node = reinterpret_cast<LeafPage *>(new_root_page->GetData());
-      new_root_node->SetParentPageId(INVALID_PAGE_ID);
+      BasicPageGuard new_root_guard = buffer_pool_manager_->FetchPageBasic(new_root_page_id);
+      new_root_guard.AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
       root_page_id_ = new_root_page_id;
       UpdateRootPageId(0);
-      buffer_pool_manager_->UnpinPage(new_root_page_id, true);
       return true;
     }
   }
@@ -605,6 +603,56 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
   // throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key) {
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return {};
+    }
+    Page *page = buffer_pool_manager_->FetchPage(root_page_id);
+    if (page == nullptr) {
+      return {};
+    }
+    // The pin keeps the frame from being reused while the page is read without a latch.
+    BasicPageGuard guard(buffer_pool_manager_, page);
+    uint64_t version;
+    // A writer that replaced the root latched the old one, so checking the root id once the version is known suffices.
+    if (!page->TryOptimisticRead(&version) || root_page_id_ != root_page_id) {
+      continue;
+    }
+    while (true) {
+      if (reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+        ReadPageGuard leaf_guard = guard.UpgradeRead();
+        // Nothing can change the leaf now, but it may have been split or merged before the latch was taken.
+        if (page->ValidateOptimisticRead(version)) {
+          return leaf_guard;
+        }
+        break;
+      }
+      page_id_t child_page_id = reinterpret_cast<InternalPage *>(page->GetData())->Lookup(key, comparator_);
+      // Never follow a child pointer that was read while a writer changed the page.
+      if (!page->ValidateOptimisticRead(version)) {
+        break;
+      }
+      Page *child_page = buffer_pool_manager_->FetchPage(child_page_id);
+      if (child_page == nullptr) {
+        return {};
+      }
+      BasicPageGuard child_guard(buffer_pool_manager_, child_page);
+      uint64_t child_version;
+      // The parent still points to the child if it did not change meanwhile, otherwise the child may be gone.
+      if (!child_page->TryOptimisticRead(&child_version) || !page->ValidateOptimisticRead(version)) {
+        break;
+      }
+      guard = std::move(child_guard);
+      page = child_page;
+      version = child_version;
+    }
+  }
+  return {};
+}
+
 // /** Concurrent index: the pages that were latched during index operation. */
 // std::shared_ptr<std::deque<Page *>> page_set_;
 // /** Concurrent index: the page IDs that were deleted during index operation.*/
@@ -752,6 +800,18 @@ void BPLUSTREE_TYPE::UnlatchAndUnpinAndDelete(Transaction *transaction, Operatio
   del_page_set->clear();
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::GetLatchedPage(Transaction *transaction, page_id_t page_id) {
+  auto page_set = transaction->GetPageSet();
+  // The parent of the page being changed was latched last but one, so search from the back.
+  for (auto it = page_set->rbegin(); it != page_set->rend(); ++it) {
+    if ((*it)->GetPageId() == page_id) {
+      return *it;
+    }
+  }
+  return nullptr;
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
@@ -762,7 +822,9 @@ void BPLUSTREE_TYPE::UnlatchAndUnpinAndDelete(Transaction *transaction, Operatio
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // Every index keeps its root in the header page, so it is latched against the other indexes.
+  WritePageGuard header_guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *header_page = header_guard.AsMut<HeaderPage>();
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -770,7 +832,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
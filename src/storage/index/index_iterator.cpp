@@ -15,6 +15,7 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, Page *page, int index)
     : buffer_pool_manager_(bpm), page_(page), index_(index) {
   leaf_page_ = reinterpret_cast<LeafPage *>(page->GetData());
+  ReadAhead();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -41,10 +42,19 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
     buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
     page_ = next_leaf_page;
     leaf_page_ = reinterpret_cast<LeafPage *>(next_leaf_page->GetData());
+    ReadAhead();
   }
   return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReadAhead() {
+  // The range scan will most likely step onto the next leaf, start reading it while this one is being consumed.
+  if (leaf_page_->GetNextPageId() != INVALID_PAGE_ID) {
+    buffer_pool_manager_->PrefetchPage(leaf_page_->GetNextPageId());
+  }
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// background_writer_test.cpp
+//
+// Identification: test/buffer/background_writer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Wait until the background writer has cleaned the given number of pages, for at most a few seconds. */
+static bool WaitForCleanedPages(BufferPoolManager *bpm, size_t num_pages) {
+  for (int i = 0; i < 5000; i++) {
+    if (bpm->GetBackgroundWriterStats().pages_cleaned_ >= num_pages) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, CleanAheadOfEvictionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: without a background writer, every eviction of a dirty page writes in the foreground.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetBackgroundWriterStats().foreground_writes_);
+  EXPECT_EQ(0, bpm->GetBackgroundWriterStats().pages_cleaned_);
+
+  // Scenario: with the writer running, the dirty resident pages are cleaned in the background, and evicting them
+  // later does not write in the foreground anymore.
+  bpm->StartBackgroundWriter(buffer_pool_size, buffer_pool_size);
+  ASSERT_TRUE(WaitForCleanedPages(bpm, buffer_pool_size));
+  bpm->StopBackgroundWriter();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetBackgroundWriterStats().foreground_writes_);
+
+  // Scenario: the pages the writer cleaned made it to disk.
+  for (size_t i = buffer_pool_size; i < 2 * buffer_pool_size; i++) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, ConcurrentUpdateTest) {
+  const std::string db_name = "test.db";
+  const size_t num_threads = 4;
+  const page_id_t num_pages = 64;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 8, disk_manager);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->StartBackgroundWriter(8, 16);
+
+  // Scenario: every thread keeps bumping a counter on its own pages while the writers clean frames underneath. A page
+  // that is changed while its old copy is being written must stay dirty, so no update is lost.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages / num_threads - 1);
+      for (int i = 0; i < 2000; i++) {
+        page_id_t page_id = dist(rng) * num_threads + tid;
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        page->WLatch();
+        ++*reinterpret_cast<int *>(page->GetData());
+        page->WUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  bpm->StopBackgroundWriter();
+
+  // Push every page out of the pool once, so the counters are read back from disk.
+  int total = 0;
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    page_id_t new_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(new_page_id, false));
+  }
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    total += *reinterpret_cast<int *>(page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(static_cast<int>(num_threads) * 2000, total);
+  EXPECT_GT(bpm->GetBackgroundWriterStats().pages_cleaned_, 0);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, RingReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_hot_pages = 16;
+  const page_id_t num_cold_pages = 500;
+  const size_t ring_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < num_hot_pages + num_cold_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id = 0; page_id < num_hot_pages; page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a scan through a strategy only ever occupies ring_size frames, no matter how many pages it reads. The
+  // scan stops short of the cold pages that are still resident from creating them.
+  BufferAccessStrategy strategy(ring_size);
+  std::set<Page *> frames;
+  const page_id_t scan_end = num_hot_pages + num_cold_pages - static_cast<page_id_t>(buffer_pool_size);
+  for (page_id_t page_id = num_hot_pages; page_id < scan_end; page_id++) {
+    Page *page = bpm->FetchPage(page_id, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    frames.insert(page);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(ring_size, frames.size());
+
+  // Scenario: the hot pages survived the scan and are still in the buffer pool.
+  int reads_before = disk_manager->GetNumReads();
+  for (page_id_t page_id = 0; page_id < num_hot_pages; page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads_before, disk_manager->GetNumReads());
+
+  // Scenario: a ring frame that is pinned by someone else is not reused, the scan falls back to a regular victim.
+  Page *pinned = bpm->FetchPage(scan_end - 1);
+  ASSERT_NE(nullptr, pinned);
+  for (page_id_t page_id = num_hot_pages; page_id < num_hot_pages + 2 * static_cast<page_id_t>(ring_size); page_id++) {
+    Page *page = bpm->FetchPage(page_id, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_NE(pinned, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(std::to_string(scan_end - 1), std::string(pinned->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(scan_end - 1, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, TableScanTest) {
+  const size_t buffer_pool_size = 64;
+  const page_id_t num_hot_pages = 16;
+  const int num_tuples = 1000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(2, buffer_pool_size / 2, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+
+  // Fill a table that is several times larger than the buffer pool, a handful of tuples fit on a page.
+  Schema schema({Column{"a", TypeId::VARCHAR, 1000}});
+  Tuple tuple({Value(TypeId::VARCHAR, std::string(800, 'x'))}, &schema);
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  std::vector<page_id_t> hot_page_ids;
+  for (page_id_t i = 0; i < num_hot_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    hot_page_ids.push_back(page_id);
+  }
+
+  // Scenario: a full sequential scan reads every tuple, yet the hot pages are still resident afterwards.
+  int num_scanned = 0;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    num_scanned++;
+  }
+  EXPECT_EQ(num_tuples, num_scanned);
+  int reads_before = disk_manager->GetNumReads();
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads_before, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
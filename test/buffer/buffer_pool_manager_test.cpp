@@ -10,10 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "recovery/log_manager.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -29,7 +34,7 @@ TEST(BufferPoolManagerTest, /*DISABLED_*/ BinaryDataTest) {
   std::uniform_int_distribution<char> uniform_dist(0);
 
   auto *disk_manager = new DiskManager(db_name);
-  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
   auto *page0 = bpm->NewPage(&page_id_temp);
@@ -91,7 +96,7 @@ TEST(BufferPoolManagerTest, /*DISABLED_*/ SampleTest) {
   const size_t buffer_pool_size = 10;
 
   auto *disk_manager = new DiskManager(db_name);
-  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
   auto *page0 = bpm->NewPage(&page_id_temp);
@@ -141,4 +146,263 @@ TEST(BufferPoolManagerTest, /*DISABLED_*/ SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentEvictionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_pages = 16;
+  const size_t num_threads = 8;
+  const size_t num_ops_per_thread = 2000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: Many more threads than frames fetch the same few pages, so pages are constantly being written back and
+  // read in while other threads ask for them. Every fetch must still see the content of the page it asked for.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (size_t i = 0; i < num_ops_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+        // Mark every other access dirty, so that evictions have to write the page back.
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, i % 2 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, buffer_pool_size / 2, disk_manager);
+
+  // Scenario: creating pages is neither a hit nor a miss. Once the pool is full, every new page evicts a dirty one and
+  // writes it back.
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+  EXPECT_EQ(buffer_pool_size, stats.evictions_);
+  EXPECT_EQ(buffer_pool_size, stats.dirty_writes_);
+
+  // Scenario: the most recent pages are hits, the older ones are misses that evict clean pages.
+  bpm->ResetStats();
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(2 * buffer_pool_size); page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.hits_);
+  EXPECT_EQ(2 * buffer_pool_size, stats.misses_);
+  EXPECT_EQ(2 * buffer_pool_size, stats.evictions_);
+  EXPECT_EQ(buffer_pool_size, stats.dirty_writes_);
+  for (page_id_t page_id = buffer_pool_size; page_id < static_cast<page_id_t>(2 * buffer_pool_size); page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size, stats.hits_);
+  EXPECT_DOUBLE_EQ(1.0 / 3, stats.HitRatio());
+
+  // Scenario: every miss lands in exactly one bucket of the latency histogram.
+  size_t histogram_total = 0;
+  for (size_t count : stats.miss_latency_histogram_) {
+    histogram_total += count;
+  }
+  EXPECT_EQ(stats.misses_, histogram_total);
+
+  // Scenario: a reset starts every counter over.
+  bpm->ResetStats();
+  stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.hits_ + stats.misses_ + stats.evictions_ + stats.dirty_writes_ + stats.latch_wait_ns_);
+  EXPECT_EQ(0, stats.HitRatio());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  for (size_t i = 1; i < buffer_pool_size; i++) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+
+  // Scenario: the dirty pages and the pinned one, which may have changed without being marked dirty yet, reach disk.
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  char data[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(data));
+  }
+
+  // Scenario: flushed pages are clean, only the pinned page is written again, and evicting the others writes nothing.
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size) + 1, disk_manager->GetNumWrites());
+  bpm->ResetStats();
+  for (size_t i = 1; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().dirty_writes_);
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], true));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ReuseDeletedPageTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(1, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "OLD SECRET");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(true, bpm->FlushPage(page_id));
+  EXPECT_EQ(true, bpm->DeletePage(page_id));
+
+  // Scenario: a new page that reuses the id of a deleted one reads as zeros, even if it is evicted without a change.
+  page_id_t reused_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&reused_page_id));
+  EXPECT_EQ(page_id, reused_page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(reused_page_id, false));
+  page_id_t other_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(other_page_id, false));
+  page = bpm->FetchPage(reused_page_id);
+  ASSERT_NE(nullptr, page);
+  char zeros[PAGE_SIZE] = {0};
+  EXPECT_EQ(0, memcmp(zeros, page->GetData(), PAGE_SIZE));
+  EXPECT_EQ(true, bpm->UnpinPage(reused_page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, WriteAheadLogTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(2, disk_manager, log_manager);
+  // Without a flush thread, the log is flushed by the thread that forces it.
+  enable_logging = true;
+  auto append = [&](int count) {
+    for (int i = 0; i < count; i++) {
+      LogRecord log_record(0, INVALID_LSN, LogRecordType::BEGIN);
+      log_manager->AppendLogRecord(&log_record);
+    }
+  };
+  append(3);
+  log_manager->FlushUntil(2);
+  append(7);
+
+  page_id_t page_id_a;
+  Page *page_a = bpm->NewPage(&page_id_a);
+  ASSERT_NE(nullptr, page_a);
+  page_a->SetLSN(8);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_a, true));
+  page_id_t page_id_b;
+  Page *page_b = bpm->NewPage(&page_id_b);
+  ASSERT_NE(nullptr, page_b);
+  page_b->SetLSN(1);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_b, true));
+
+  // Scenario: the victim is a dirty page whose log is already persistent, ahead of an older one that would force it.
+  page_id_t page_id_c;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_c));
+  EXPECT_EQ(2, log_manager->GetPersistentLSN());
+  EXPECT_EQ(0, bpm->GetStats().log_forces_);
+  int reads = disk_manager->GetNumReads();
+  ASSERT_EQ(page_a, bpm->FetchPage(page_id_a));
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_a, false));
+
+  // Scenario: with no other victim, the log is forced up to the page LSN before the page is written.
+  append(5);
+  page_id_t page_id_d;
+  Page *page_d = bpm->NewPage(&page_id_d);
+  ASSERT_NE(nullptr, page_d);
+  EXPECT_LE(8, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, bpm->GetStats().log_forces_);
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id_a, data);
+  lsn_t lsn;
+  memcpy(&lsn, data + 4, sizeof(lsn));
+  EXPECT_EQ(8, lsn);
+
+  // Scenario: flushing a page forces the log too.
+  lsn_t persistent_lsn = log_manager->GetPersistentLSN();
+  append(1);
+  page_d->SetLSN(persistent_lsn + 1);
+  bpm->FlushPage(page_id_d);
+  EXPECT_EQ(persistent_lsn + 1, log_manager->GetPersistentLSN());
+  EXPECT_EQ(2, bpm->GetStats().log_forces_);
+
+  enable_logging = false;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_resize_test.cpp
+//
+// Identification: test/buffer/buffer_pool_resize_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, GrowAndShrinkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t max_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm =
+      new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU, max_pool_size);
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+
+  // Scenario: the pool cannot be resized to nothing or beyond its maximum.
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(max_pool_size + 1));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: fill the pool with pinned pages, then grow it. The pinned pages stay where they are and the new frames
+  // can be used right away.
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    page_ids.push_back(page_id);
+    pages.push_back(page);
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  for (size_t i = buffer_pool_size; i < max_pool_size; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    page_ids.push_back(page_id);
+    pages.push_back(page);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  for (size_t i = 0; i < max_pool_size; i++) {
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+
+  // Scenario: shrinking writes the dirty pages of the retired frames back, and no more than the new size of pages
+  // can be pinned at once.
+  size_t writes_before = disk_manager->GetNumWrites();
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(writes_before + max_pool_size - buffer_pool_size, disk_manager->GetNumWrites());
+  std::vector<page_id_t> new_page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_LT(page, bpm->GetPages() + buffer_pool_size);
+    new_page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  for (page_id_t new_page_id : new_page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(new_page_id, false));
+  }
+
+  // Scenario: every page survived the round trip.
+  for (size_t i = 0; i < max_pool_size; i++) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, ShrinkWaitsForPinnedPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: a shrink does not finish while a page in a retired frame is pinned, and the pinned page stays valid.
+  std::atomic<bool> resized{false};
+  std::thread resizer([&] {
+    EXPECT_TRUE(bpm->Resize(2));
+    resized = true;
+  });
+  for (size_t i = 0; i < buffer_pool_size - 1; i++) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(resized);
+  Page *last = bpm->GetPages() + buffer_pool_size - 1;
+  EXPECT_EQ(std::to_string(page_ids.back()), std::string(last->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids.back(), true));
+  resizer.join();
+  EXPECT_TRUE(resized);
+  EXPECT_EQ(2, bpm->GetPoolSize());
+
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolResizeTest, ParallelResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr,
+                                            ReplacerPolicy::LRU, 2 * buffer_pool_size);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: the size is split between the instances and rounded up, and no instance grows beyond its maximum.
+  EXPECT_TRUE(bpm->Resize(num_instances * buffer_pool_size + 1));
+  EXPECT_EQ(num_instances * (buffer_pool_size + 1), bpm->GetPoolSize());
+  EXPECT_FALSE(bpm->Resize(2 * num_instances * buffer_pool_size + 1));
+  EXPECT_EQ(num_instances * (buffer_pool_size + 1), bpm->GetPoolSize());
+  EXPECT_TRUE(bpm->Resize(num_instances));
+  EXPECT_EQ(num_instances, bpm->GetPoolSize());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
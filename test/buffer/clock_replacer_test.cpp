@@ -10,16 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstdio>
+#include <random>
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "buffer/clock_replacer.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +63,133 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_frames = 1024;
+  const size_t num_threads = 8;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread owns the frames congruent to its id and keeps pinning and unpinning them, while half of
+  // the threads also take victims. The size must stay consistent with the frame states throughout.
+  std::vector<std::vector<frame_id_t>> victims(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, &victims, tid] {
+      std::default_random_engine rng(tid);
+      for (int round = 0; round < 100; round++) {
+        for (size_t frame_id = tid; frame_id < num_frames; frame_id += num_threads) {
+          clock_replacer.Pin(frame_id);
+          if (rng() % 2 == 0) {
+            clock_replacer.Unpin(frame_id);
+          }
+        }
+        frame_id_t victim;
+        if (tid % 2 == 0 && clock_replacer.Victim(&victim)) {
+          victims[tid].push_back(victim);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: unpin every frame once more and drain the replacer from several threads. Every frame comes out exactly
+  // once and the replacer ends up empty.
+  for (size_t frame_id = 0; frame_id < num_frames; frame_id++) {
+    clock_replacer.Pin(frame_id);
+    clock_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+  for (auto &thread_victims : victims) {
+    thread_victims.clear();
+  }
+  threads.clear();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, &victims, tid] {
+      frame_id_t victim;
+      while (clock_replacer.Victim(&victim)) {
+        victims[tid].push_back(victim);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<frame_id_t> all_victims;
+  for (auto &thread_victims : victims) {
+    all_victims.insert(all_victims.end(), thread_victims.begin(), thread_victims.end());
+  }
+  std::sort(all_victims.begin(), all_victims.end());
+  ASSERT_EQ(num_frames, all_victims.size());
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(static_cast<frame_id_t>(i), all_victims[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, BufferPoolStressTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 64;
+  const size_t num_threads = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::CLOCK);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a buffer pool using the clock replacer still hands out the right page under heavy eviction.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (int i = 0; i < 2000; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, i % 3 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(ClockReplacerTest, PutBackTest) {
+  ClockReplacer clock_replacer(7);
+  for (frame_id_t frame_id = 1; frame_id <= 3; frame_id++) {
+    clock_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: a victim that is put back gets no second chance, unlike a frame that is unpinned again.
+  int value;
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  clock_replacer.PutBack(1);
+  clock_replacer.Pin(3);
+  clock_replacer.Unpin(3);
+  EXPECT_EQ(3, clock_replacer.Size());
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+}
+
 }  // namespace bustub
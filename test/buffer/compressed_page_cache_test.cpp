@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Fill a page like a table page of small integer rows: a short header, then rows of mostly zero bytes. */
+static void FillSparseRows(char *data, int seed) {
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, 32, "header %d", seed);
+  for (int offset = 64, row = 0; offset + 16 <= PAGE_SIZE; offset += 16, row++) {
+    int32_t key = seed * 1000 + row;
+    int32_t value = row % 7;
+    memcpy(data + offset, &key, sizeof(key));
+    memcpy(data + offset + 8, &value, sizeof(value));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, CodecTest) {
+  char page[PAGE_SIZE];
+  char result[PAGE_SIZE];
+  std::vector<char> compressed;
+
+  // Scenario: an empty page compresses to a few bytes.
+  memset(page, 0, PAGE_SIZE);
+  ASSERT_TRUE(CompressedPageCache::Compress(page, &compressed));
+  EXPECT_LT(compressed.size(), 64);
+  ASSERT_TRUE(CompressedPageCache::Decompress(compressed, result));
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+
+  // Scenario: sparse integer rows compress by more than 2x.
+  FillSparseRows(page, 42);
+  ASSERT_TRUE(CompressedPageCache::Compress(page, &compressed));
+  EXPECT_LT(compressed.size() * 2, static_cast<size_t>(PAGE_SIZE));
+  ASSERT_TRUE(CompressedPageCache::Decompress(compressed, result));
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+
+  // Scenario: random bytes do not compress, half random bytes still round trip.
+  std::mt19937 rng(0);
+  for (char &byte : page) {
+    byte = static_cast<char>(rng());
+  }
+  EXPECT_FALSE(CompressedPageCache::Compress(page, &compressed));
+  memset(page + PAGE_SIZE / 2, 'x', PAGE_SIZE / 2);
+  ASSERT_TRUE(CompressedPageCache::Compress(page, &compressed));
+  ASSERT_TRUE(CompressedPageCache::Decompress(compressed, result));
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+
+  // Scenario: a truncated page is rejected.
+  compressed.resize(compressed.size() / 2);
+  EXPECT_FALSE(CompressedPageCache::Decompress(compressed, result));
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, BudgetTest) {
+  char page[PAGE_SIZE];
+  char result[PAGE_SIZE];
+  std::vector<char> compressed;
+  FillSparseRows(page, 0);
+  ASSERT_TRUE(CompressedPageCache::Compress(page, &compressed));
+
+  // Scenario: the cache keeps as many pages as fit into the budget and drops the oldest ones first.
+  CompressedPageCache cache(3 * compressed.size() + compressed.size() / 2);
+  for (page_id_t page_id = 0; page_id < 5; page_id++) {
+    FillSparseRows(page, page_id);
+    cache.Insert(page_id, page);
+  }
+  EXPECT_EQ(3, cache.GetNumPages());
+  EXPECT_FALSE(cache.Take(0, result));
+  EXPECT_FALSE(cache.Take(1, result));
+
+  // Scenario: taking a page hands out its contents and removes it.
+  ASSERT_TRUE(cache.Take(3, result));
+  FillSparseRows(page, 3);
+  EXPECT_EQ(0, memcmp(page, result, PAGE_SIZE));
+  EXPECT_FALSE(cache.Take(3, result));
+  EXPECT_EQ(2, cache.GetNumPages());
+
+  // Scenario: erasing a page removes it, and the size drops to zero once the cache is empty.
+  cache.Erase(2);
+  cache.Erase(4);
+  EXPECT_EQ(0, cache.GetNumPages());
+  EXPECT_EQ(0, cache.GetSize());
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_pages = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU, 0,
+                                            num_pages * PAGE_SIZE / 2);
+  ASSERT_NE(nullptr, bpm->GetCompressedPageCache());
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    FillSparseRows(page->GetData(), page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: pages evicted from the pool are fetched back from the compressed page cache, not from disk.
+  int reads_before = disk_manager->GetNumReads();
+  bpm->ResetStats();
+  char expected[PAGE_SIZE];
+  for (int round = 0; round < 2; round++) {
+    for (page_id_t page_id : page_ids) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      FillSparseRows(expected, page_id);
+      EXPECT_EQ(0, memcmp(expected, page->GetData(), PAGE_SIZE));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+  EXPECT_EQ(reads_before, disk_manager->GetNumReads());
+  EXPECT_EQ(2 * num_pages, bpm->GetStats().compressed_hits_);
+
+  // Scenario: a page changed in the pool is not served stale from the cache after it is evicted again.
+  Page *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "changed");
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], true));
+  for (size_t i = 1; i <= buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+  page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("changed", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: deleting a page that only lives in the cache drops it from there.
+  size_t cached_before = bpm->GetCompressedPageCache()->GetNumPages();
+  EXPECT_EQ(true, bpm->DeletePage(page_ids[num_pages - 1]));
+  EXPECT_EQ(cached_before - 1, bpm->GetCompressedPageCache()->GetNumPages());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
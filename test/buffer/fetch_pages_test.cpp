@@ -0,0 +1,173 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_pages_test.cpp
+//
+// Identification: test/buffer/fetch_pages_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/** Create num_pages pages that each hold their page id as a string, and leave them unpinned on disk. */
+static std::vector<page_id_t> CreatePages(BufferPoolManager *bpm, size_t num_pages) {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  bpm->FlushAllPages();
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(FetchPagesTest, InstanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids = CreatePages(bpm, 2 * buffer_pool_size);
+
+  // Scenario: a batch of hits, misses and a duplicate returns every page in order, pins the duplicate twice and reads
+  // every missing page exactly once.
+  std::vector<page_id_t> batch = {page_ids[19], page_ids[0], page_ids[12], page_ids[0], page_ids[5], page_ids[1]};
+  int reads_before = disk_manager->GetNumReads();
+  std::vector<Page *> pages = bpm->FetchPages(batch);
+  ASSERT_EQ(batch.size(), pages.size());
+  EXPECT_EQ(3, disk_manager->GetNumReads() - reads_before);
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(batch[i], pages[i]->GetPageId());
+    EXPECT_EQ(std::to_string(batch[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(pages[1], pages[3]);
+  EXPECT_EQ(2, pages[1]->GetPinCount());
+  for (page_id_t page_id : batch) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(false, bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: a batch larger than the pool fetches as many pages as there are frames, the rest come back empty.
+  pages = bpm->FetchPages(page_ids);
+  size_t num_fetched = 0;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (pages[i] != nullptr) {
+      EXPECT_EQ(std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+      num_fetched++;
+    }
+  }
+  EXPECT_EQ(buffer_pool_size, num_fetched);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(FetchPagesTest, ParallelTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 3;
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids = CreatePages(bpm, 2 * num_instances * buffer_pool_size);
+
+  // Scenario: a batch spread over every instance comes back in the order it was asked for.
+  std::vector<page_id_t> batch(page_ids.begin(), page_ids.begin() + num_instances * buffer_pool_size);
+  std::shuffle(batch.begin(), batch.end(), std::default_random_engine(0));
+  std::vector<Page *> pages = bpm->FetchPages(batch);
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(std::to_string(batch[i]), std::string(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(batch[i], false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(FetchPagesTest, TableHeapGetTuplesTest) {
+  const int num_tuples = 200;
+
+  // A pool smaller than the table, so GetTuples has to split the pages into several batches.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+
+  Schema schema({Column{"a", TypeId::VARCHAR, 1000}});
+  std::vector<RID> rids;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple({Value(TypeId::VARCHAR, std::to_string(i))}, &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    rids.push_back(rid);
+  }
+
+  // Scenario: tuples read in random order come back in the order of their rids, duplicates included.
+  std::vector<int> order(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::default_random_engine(0));
+  order.push_back(order.front());
+  std::vector<RID> batch;
+  for (int i : order) {
+    batch.push_back(rids[i]);
+  }
+  std::vector<Tuple> tuples;
+  EXPECT_TRUE(table->GetTuples(batch, &tuples, transaction));
+  ASSERT_EQ(batch.size(), tuples.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_TRUE(tuples[i].IsAllocated());
+    EXPECT_EQ(batch[i], tuples[i].GetRid());
+    EXPECT_EQ(std::to_string(order[i]), tuples[i].GetValue(&schema, 0).GetAs<char *>());
+  }
+
+  // Scenario: a deleted tuple is left unallocated and the rest are still read.
+  ASSERT_TRUE(table->MarkDelete(rids[7], transaction));
+  table->ApplyDelete(rids[7], transaction);
+  EXPECT_FALSE(table->GetTuples({rids[6], rids[7], rids[8]}, &tuples, transaction));
+  EXPECT_TRUE(tuples[0].IsAllocated());
+  EXPECT_FALSE(tuples[1].IsAllocated());
+  EXPECT_TRUE(tuples[2].IsAllocated());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
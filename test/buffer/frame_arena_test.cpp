@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, AlignmentTest) {
+  // Scenario: a small arena is zeroed, every frame is page aligned and the frames are contiguous.
+  {
+    FrameArena arena(10);
+    for (frame_id_t i = 0; i < 10; i++) {
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(i)) % PAGE_SIZE);
+      EXPECT_EQ(arena.GetFrame(0) + i * PAGE_SIZE, arena.GetFrame(i));
+      EXPECT_EQ(0, arena.GetFrame(i)[0]);
+      EXPECT_EQ(0, arena.GetFrame(i)[PAGE_SIZE - 1]);
+    }
+  }
+
+  // Scenario: an arena of at least one huge page starts on a huge page boundary, whether or not huge pages are
+  // reserved on this machine.
+  {
+    const size_t num_frames = HUGE_PAGE_SIZE / PAGE_SIZE + 1;
+    FrameArena arena(num_frames);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % HUGE_PAGE_SIZE);
+    arena.GetFrame(num_frames - 1)[PAGE_SIZE - 1] = 'x';
+    EXPECT_EQ('x', arena.GetFrame(num_frames - 1)[PAGE_SIZE - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the page metadata of neighbouring frames lives in separate cache lines, the data in aligned frames.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages + i) % CACHE_LINE_SIZE);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+  }
+
+  // Scenario: pages that go through the arena frames are written out and read back intact.
+  for (int round = 0; round < 3; round++) {
+    for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+      page_id_t page_id = static_cast<page_id_t>(i);
+      Page *page = round == 0 ? bpm->NewPage(&page_id) : bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      if (round > 0) {
+        EXPECT_EQ(std::to_string(page_id + round - 1), std::string(page->GetData()));
+      }
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id + round);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+  }
+
+  // Scenario: a standalone page owns its data.
+  Page standalone;
+  EXPECT_EQ(0, standalone.GetData()[0]);
+  EXPECT_EQ(INVALID_PAGE_ID, standalone.GetPageId());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: access six frames, frame 1 twice, and unpin all of them.
+  for (frame_id_t frame_id : {1, 2, 3, 4, 5, 6, 1}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single access have an infinite backward K-distance and go first, in order of their
+  // first access. Frame 1 has two accesses and is kept even though it was accessed first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: pinned frames cannot be victimized, pinning a victimized frame has no effect.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: give frame 6 a second access. Both remaining frames now have K accesses, and frame 1 has the older
+  // second most recent one.
+  lru_k_replacer.RecordAccess(6);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: unpinning frame 5 makes it evictable again, removing it forgets it altogether.
+  lru_k_replacer.Unpin(5);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  lru_k_replacer.Remove(5);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+/**
+ * Runs a few rounds of point lookups on a small hot set, each round interleaved with a sequential scan over cold
+ * pages that is larger than the buffer pool, and returns how many of the lookups had to go to disk.
+ */
+static int ScanWithPointLookups(ReplacerPolicy replacer_policy) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_hot_pages = 32;
+  const int num_cold_pages = 1000;
+  const int num_rounds = 10;
+  const int scan_length = 100;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_policy);
+
+  // Pages [0, num_hot_pages) are hot, the rest is only ever scanned.
+  for (int i = 0; i < num_hot_pages + num_cold_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  auto lookup = [bpm](page_id_t page_id) {
+    Page *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  };
+
+  // Warm up the hot set, so it is resident and every hot page has a history.
+  for (int i = 0; i < 2; i++) {
+    for (page_id_t page_id = 0; page_id < num_hot_pages; page_id++) {
+      lookup(page_id);
+    }
+  }
+
+  int hot_misses = 0;
+  page_id_t next_cold_page = num_hot_pages;
+  for (int round = 0; round < num_rounds; round++) {
+    for (int i = 0; i < scan_length; i++) {
+      lookup(next_cold_page);
+      next_cold_page = num_hot_pages + (next_cold_page - num_hot_pages + 1) % num_cold_pages;
+    }
+    int reads_before = disk_manager->GetNumReads();
+    for (page_id_t page_id = 0; page_id < num_hot_pages; page_id++) {
+      lookup(page_id);
+    }
+    hot_misses += disk_manager->GetNumReads() - reads_before;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+  return hot_misses;
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  // Scenario: under LRU, every scan pushes the whole hot set out of the buffer pool, so every lookup misses.
+  int lru_misses = ScanWithPointLookups(ReplacerPolicy::LRU);
+  EXPECT_GT(lru_misses, 0);
+
+  // Scenario: under LRU-K, scanned pages are only accessed once and are evicted before any hot page.
+  int lru_k_misses = ScanWithPointLookups(ReplacerPolicy::LRU_K);
+  EXPECT_EQ(0, lru_k_misses);
+  EXPECT_LT(lru_k_misses, lru_misses);
+}
+
+TEST(LRUKReplacerTest, PutBackTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+  for (frame_id_t frame_id : {1, 2, 3, 1, 2, 3}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 1; frame_id <= 3; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: a victim that is put back keeps its access history, it is neither newer nor older than before.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  lru_k_replacer.PutBack(1);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  for (frame_id_t frame_id = 1; frame_id <= 3; frame_id++) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(frame_id, value);
+  }
+
+  // Scenario: a frame put back after its history was forgotten counts as never accessed, and goes first.
+  lru_k_replacer.RecordAccess(4);
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Remove(1);
+  lru_k_replacer.PutBack(1);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
+
+}  // namespace bustub
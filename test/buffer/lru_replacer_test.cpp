@@ -59,4 +59,25 @@ TEST(LRUReplacerTest, /*DISABLED_*/ SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(LRUReplacerTest, PutBackTest) {
+  LRUReplacer lru_replacer(7);
+  for (frame_id_t frame_id = 1; frame_id <= 4; frame_id++) {
+    lru_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: victims put back in reverse order are taken again in their old order, before the newer frames.
+  int first;
+  int second;
+  ASSERT_TRUE(lru_replacer.Victim(&first));
+  ASSERT_TRUE(lru_replacer.Victim(&second));
+  lru_replacer.PutBack(second);
+  lru_replacer.PutBack(first);
+  EXPECT_EQ(4, lru_replacer.Size());
+  int value;
+  for (frame_id_t frame_id = 1; frame_id <= 4; frame_id++) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(frame_id, value);
+  }
+}
+
 }  // namespace bustub
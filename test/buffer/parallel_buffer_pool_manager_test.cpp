@@ -0,0 +1,256 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: New pages are handed out round robin, so we can fill every frame of every instance.
+  std::vector<page_id_t> page_ids{page_id_temp};
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(static_cast<page_id_t>(i), page_ids[i]);
+  }
+
+  // Scenario: Once every instance is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: Unpinning a page of one instance only frees a frame in that instance, but the round robin search
+  // still finds it.
+  EXPECT_EQ(true, bpm->UnpinPage(1, true));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, page_id_temp % static_cast<page_id_t>(num_instances));
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+
+  // Scenario: After unpinning page 0 and creating a new page, we should still read back what we wrote.
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->DeletePage(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const size_t num_threads = 8;
+  const size_t num_pages_per_thread = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(4, 16, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::vector<page_id_t> page_ids;
+      for (size_t i = 0; i < num_pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%zu-%d", tid, page_id);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(tid) + "-" + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * Fetch the pages of a parallel buffer pool from many threads, most of the time one of the hot pages that fit into the
+ * pool. The total number of frames is the same whatever the number of instances, so every configuration has the same
+ * hit ratio and any difference in throughput comes from latch contention. Every fetch must succeed and find its page.
+ * @return the number of fetches per second
+ */
+static double RunSkewedFetches(size_t num_instances, size_t num_ops_per_thread) {
+  const size_t total_frames = 256;
+  const size_t num_pages = 512;
+  const size_t num_threads = 16;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, total_frames / num_instances, disk_manager);
+
+  // Populate the database so that every page exists on disk.
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    if (page == nullptr) {
+      break;
+    }
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid, num_ops_per_thread] {
+      std::default_random_engine rng(tid);
+      // Skew the accesses so most of them hit the hot pages that fit into the pool.
+      std::uniform_int_distribution<page_id_t> hot_dist(0, total_frames / 2 - 1);
+      std::uniform_int_distribution<page_id_t> cold_dist(0, num_pages - 1);
+      for (size_t i = 0; i < num_ops_per_thread; i++) {
+        page_id_t page_id = (i % 10 == 0) ? cold_dist(rng) : hot_dist(rng);
+        // Each thread pins one page at a time, and every instance has at least as many frames as there are threads.
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+  return num_threads * num_ops_per_thread / elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrentFetchTest) {
+  // Scenario: however finely the pool is sharded, concurrent fetches find every page as it was written.
+  for (size_t num_instances = 1; num_instances <= 16; num_instances *= 4) {
+    RunSkewedFetches(num_instances, 500);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmarkTest) {
+  const size_t num_ops_per_thread = 5000;
+  for (size_t num_instances = 1; num_instances <= 16; num_instances *= 2) {
+    [[maybe_unused]] double throughput = RunSkewedFetches(num_instances, num_ops_per_thread);
+    LOG_INFO("%zu instances: %zu ops/s", num_instances, static_cast<size_t>(throughput));
+  }
+}
+
+/** A disk manager that remembers the page ids of every batch written. */
+class RecordingDiskManager : public DiskManager {
+ public:
+  explicit RecordingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) override {
+    batches_.push_back(page_ids);
+    DiskManager::WritePages(page_ids, page_data);
+  }
+
+  std::vector<std::vector<page_id_t>> batches_;
+};
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 8;
+  const size_t num_pages = num_instances * buffer_pool_size / 4;
+
+  auto *disk_manager = new RecordingDiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the dirty pages of all instances are written as one batch in page id order, and the file is synced once.
+  bpm->FlushAllPages();
+  ASSERT_EQ(1, disk_manager->batches_.size());
+  std::vector<page_id_t> &batch = disk_manager->batches_.front();
+  EXPECT_EQ(num_pages, batch.size());
+  EXPECT_TRUE(std::is_sorted(batch.begin(), batch.end()));
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  char data[PAGE_SIZE];
+  for (page_id_t page_id : batch) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(data));
+  }
+
+  // Scenario: the flushed pages are clean, flushing again writes nothing.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->batches_.size());
+  EXPECT_EQ(num_pages, bpm->GetStats().dirty_writes_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
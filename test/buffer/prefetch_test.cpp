@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetch_test.cpp
+//
+// Identification: test/buffer/prefetch_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdio>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/** Wait until the disk manager has served the given number of reads, for at most a few seconds. */
+static bool WaitForReads(DiskManager *disk_manager, int num_reads) {
+  for (int i = 0; i < 5000; i++) {
+    if (disk_manager->GetNumReads() >= num_reads) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, PrefetchPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: page 0 was evicted. Prefetching it reads it in the background, a later fetch does not go to disk.
+  int reads_before = disk_manager->GetNumReads();
+  bpm->PrefetchPage(0);
+  ASSERT_TRUE(WaitForReads(disk_manager, reads_before + 1));
+  Page *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(reads_before + 1, disk_manager->GetNumReads());
+  EXPECT_EQ("0", std::string(page->GetData()));
+
+  // Scenario: the prefetch did not leave a pin behind, the fetch above holds the only one.
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(false, bpm->UnpinPage(0, false));
+
+  // Scenario: prefetching a resident page does not read anything.
+  bpm->PrefetchPage(0);
+  bpm->PrefetchPage(INVALID_PAGE_ID);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(reads_before + 1, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/** A disk manager whose batch reads wait until the test lets them through, one at a time. */
+class GatedDiskManager : public DiskManager {
+ public:
+  explicit GatedDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) override {
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      num_waiting_++;
+      cv_.notify_all();
+      cv_.wait(lock, [this] { return permits_ > 0; });
+      permits_--;
+    }
+    DiskManager::ReadPages(page_ids, page_data);
+  }
+
+  /** Let the given number of batch reads through. */
+  void Permit(int permits) {
+    std::lock_guard<std::mutex> guard(latch_);
+    permits_ += permits;
+    cv_.notify_all();
+  }
+
+  /** Wait until the given number of batch reads have been started, for at most a few seconds. */
+  bool WaitForBatches(int num_batches) {
+    std::unique_lock<std::mutex> lock(latch_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&] { return num_waiting_ >= num_batches; });
+  }
+
+ private:
+  std::mutex latch_;
+  std::condition_variable cv_;
+  int num_waiting_{0};
+  int permits_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, SmallPoolPrefetchTest) {
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new GatedDiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  page_id_t pinned_page_id = 2 * buffer_pool_size - 1;
+  ASSERT_NE(nullptr, bpm->FetchPage(pinned_page_id));
+
+  // Hold the read of page 0 until the rest of the evicted pages are queued up behind it, then hold the next batch.
+  bpm->PrefetchPage(0);
+  ASSERT_TRUE(disk_manager->WaitForBatches(1));
+  bpm->PrefetchRange(1, buffer_pool_size - 1);
+  disk_manager->Permit(1);
+  ASSERT_TRUE(disk_manager->WaitForBatches(2));
+
+  // Scenario: while a batch of a small pool is being read, it does not pin every frame, a foreground page still gets
+  // one.
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  EXPECT_NE(nullptr, page);
+  if (page != nullptr) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(pinned_page_id, false));
+
+  disk_manager->Permit(2 * buffer_pool_size);
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, PrefetchRangeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 2;
+  const page_id_t num_pages = 64;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a range spanning both instances is prefetched by both of them.
+  int reads_before = disk_manager->GetNumReads();
+  bpm->PrefetchRange(10, 6);
+  ASSERT_TRUE(WaitForReads(disk_manager, reads_before + 6));
+  for (page_id_t page_id = 10; page_id < 16; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads_before + 6, disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, TableScanReadAheadTest) {
+  const int num_tuples = 1000;
+
+  // A pool far smaller than the table, so the read-ahead and the scan's ring keep recycling the same few frames.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+
+  Schema schema({Column{"a", TypeId::VARCHAR, 1000}});
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple({Value(TypeId::VARCHAR, std::string(800, 'a' + i % 26))}, &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Scenario: scanning with read-ahead still returns every tuple exactly once and in order.
+  for (int round = 0; round < 3; round++) {
+    int num_scanned = 0;
+    for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+      EXPECT_EQ(std::string(800, 'a' + num_scanned % 26), iter->GetValue(&schema, 0).GetAs<char *>());
+      num_scanned++;
+    }
+    EXPECT_EQ(num_tuples, num_scanned);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
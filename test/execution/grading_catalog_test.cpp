@@ -14,7 +14,7 @@
 #include <unordered_set>
 #include <vector>
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "catalog/catalog.h"
 #include "catalog/table_generator.h"
 #include "concurrency/transaction_manager.h"
@@ -28,7 +28,7 @@ namespace bustub {
 // NOLINTNEXTLINE
 TEST(GradingCatalogTest, CreateTableTest) {
   auto disk_manager = new DiskManager("catalog_test.db");
-  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto bpm = new BufferPoolManagerInstance(32, disk_manager);
   auto catalog = new Catalog(bpm, nullptr, nullptr);
   std::string table_name = "potato";
 
@@ -85,7 +85,7 @@ TEST(GradingCatalogTest, CreateTableTest) {
 // NOLINTNEXTLINE
 TEST(GradingCatalogTest, CreateIndexTest) {
   auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
-  auto bpm = std::make_unique<BufferPoolManager>(32, disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
   auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
   std::unique_ptr<LogManager> log_manager_ = nullptr;
   Transaction txn(0);
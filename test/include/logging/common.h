@@ -15,6 +15,7 @@
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <random>
 #include <vector>
 
@@ -73,4 +74,13 @@ Tuple ConstructTuple(Schema *schema) {
   return Tuple(values, schema);
 }
 
+// construct a raw tuple of the given length, filled with the given byte, for tests that only look at its bytes
+Tuple MakeTuple(int32_t length, char fill) {
+  std::vector<char> storage(sizeof(int32_t) + length, fill);
+  memcpy(storage.data(), &length, sizeof(int32_t));
+  Tuple tuple;
+  tuple.DeserializeFrom(storage.data());
+  return tuple;
+}
+
 }  // namespace bustub
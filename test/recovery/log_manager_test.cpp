@@ -0,0 +1,263 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_manager.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+  };
+};
+
+/**
+ * Walk the log file record by record, checking that the lsns count up from 0 without a gap.
+ * @return the number of records in the log
+ */
+static int CheckLog(DiskManager *disk_manager) {
+  char header[20];
+  int offset = 0;
+  int num_records = 0;
+  while (disk_manager->ReadLog(header, sizeof(header), offset)) {
+    int32_t size;
+    lsn_t lsn;
+    memcpy(&size, header, sizeof(size));
+    memcpy(&lsn, header + sizeof(size), sizeof(lsn));
+    EXPECT_GE(size, static_cast<int32_t>(sizeof(header)));
+    EXPECT_EQ(num_records, lsn);
+    if (size < static_cast<int32_t>(sizeof(header)) || lsn != num_records) {
+      break;
+    }
+    offset += size;
+    num_records++;
+  }
+  return num_records;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Scenario: records of several times the log buffer are appended without a flush thread, in lsn order.
+  const int num_records = 4 * LOG_BUFFER_SIZE / 1000;
+  Tuple tuple = MakeTuple(1000, 'x');
+  for (int i = 0; i < num_records; i++) {
+    LogRecord log_record(0, i - 1, LogRecordType::INSERT, RID(i, 0), tuple);
+    EXPECT_EQ(i, log_manager->AppendLogRecord(&log_record));
+    EXPECT_EQ(i, log_record.GetLSN());
+  }
+  EXPECT_EQ(num_records, log_manager->GetNextLSN());
+  EXPECT_LT(log_manager->GetPersistentLSN(), num_records - 1);
+
+  // Scenario: flushing up to the last lsn writes every record to the log file.
+  log_manager->FlushUntil(num_records - 1);
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  EXPECT_EQ(num_records, CheckLog(disk_manager));
+
+  // Scenario: the payload of an insert record follows its header.
+  char data[20 + sizeof(RID) + sizeof(int32_t) + 1000];
+  ASSERT_TRUE(disk_manager->ReadLog(data, sizeof(data), 0));
+  RID rid;
+  memcpy(&rid, data + 20, sizeof(RID));
+  EXPECT_EQ(RID(0, 0), rid);
+  EXPECT_EQ('x', data[sizeof(data) - 1]);
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  const int num_threads = 8;
+  const int num_txns = 50;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager);
+
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  // Scenario: every commit returns with its commit record on disk, and commits running at once share flushes.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_txns; j++) {
+        Transaction *txn = txn_manager.Begin();
+        txn_manager.Commit(txn);
+        EXPECT_LE(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(disk_manager->GetNumFlushes(), num_threads * num_txns);
+
+  // Scenario: stopping the flush thread leaves a complete log with a begin and a commit record per transaction.
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  EXPECT_EQ(2 * num_threads * num_txns, log_manager->GetNextLSN());
+  EXPECT_EQ(2 * num_threads * num_txns, CheckLog(disk_manager));
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AsyncCommitTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager);
+  const auto delay = async_commit_delay;
+  const size_t max_lag = async_commit_max_lag;
+  log_manager->RunFlushThread();
+
+  // Wait up to a second for the lsn to become persistent. @return the time it took
+  auto wait_persistent = [&](lsn_t lsn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000 && log_manager->GetPersistentLSN() < lsn; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_LE(lsn, log_manager->GetPersistentLSN());
+    return std::chrono::steady_clock::now() - start;
+  };
+
+  // Scenario: an async commit returns before its commit record is flushed, and is flushed after the delay.
+  async_commit_delay = std::chrono::milliseconds(50);
+  Transaction *txn = txn_manager.Begin();
+  txn->SetAsyncCommit(true);
+  txn_manager.Commit(txn);
+  EXPECT_GT(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+  EXPECT_LT(wait_persistent(txn->GetPrevLSN()), log_timeout);
+  delete txn;
+
+  // Scenario: an async commit is flushed right away once enough log waits, however long the delay is.
+  async_commit_delay = std::chrono::seconds(10);
+  async_commit_max_lag = 1;
+  txn = txn_manager.Begin();
+  txn->SetAsyncCommit(true);
+  txn_manager.Commit(txn);
+  EXPECT_LT(wait_persistent(txn->GetPrevLSN()), log_timeout);
+  delete txn;
+
+  // Scenario: a sync commit after async ones makes all of them durable.
+  async_commit_max_lag = max_lag;
+  std::vector<Transaction *> txns;
+  for (int i = 0; i < 10; i++) {
+    txns.push_back(txn_manager.Begin());
+    txns.back()->SetAsyncCommit(i < 9);
+    txn_manager.Commit(txns.back());
+  }
+  EXPECT_LE(txns.back()->GetPrevLSN(), log_manager->GetPersistentLSN());
+  for (auto *t : txns) {
+    delete t;
+  }
+
+  async_commit_delay = delay;
+  log_manager->StopFlushThread();
+  EXPECT_EQ(log_manager->GetNextLSN(), CheckLog(disk_manager));
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+/**
+ * Commit empty transactions from several threads, and check that every BEGIN and COMMIT record made it into the log.
+ * @param[out] num_flushes the number of times the log was flushed
+ * @return the number of commits per second
+ */
+static double RunCommits(bool async_commit, int num_txns, int *num_flushes) {
+  const int num_threads = 4;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager);
+  log_manager->RunFlushThread();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_txns; j++) {
+        Transaction *txn = txn_manager.Begin();
+        txn->SetAsyncCommit(async_commit);
+        txn_manager.Commit(txn);
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  log_manager->StopFlushThread();
+  EXPECT_EQ(2 * num_threads * num_txns, CheckLog(disk_manager));
+  *num_flushes = disk_manager->GetNumFlushes();
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  return num_threads * num_txns / elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentCommitTest) {
+  // Scenario: sync and async commits from several threads all end up in the log, in lsn order without a gap.
+  for (bool async_commit : {false, true}) {
+    int num_flushes;
+    RunCommits(async_commit, 50, &num_flushes);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, DISABLED_CommitThroughputBenchmarkTest) {
+  // Async commits do not wait for the fsync, so their throughput is bounded by appending to the log buffer instead of
+  // by the disk.
+  for (bool async_commit : {false, true}) {
+    int num_flushes;
+    [[maybe_unused]] double throughput = RunCommits(async_commit, 500, &num_flushes);
+    LOG_INFO("%s commit throughput: %zu txns/s, log flushes: %d", async_commit ? "async" : "sync",
+             static_cast<size_t>(throughput), num_flushes);
+  }
+}
+
+}  // namespace bustub
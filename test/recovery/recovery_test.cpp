@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -19,7 +21,9 @@
 #include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "recovery/checkpoint_manager.h"
 #include "recovery/log_recovery.h"
+#include "storage/page/table_page.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
@@ -43,7 +47,7 @@ class RecoveryTest : public ::testing::Test {
 };
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_RedoTest) {
+TEST_F(RecoveryTest, RedoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -132,7 +136,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_UndoTest) {
+TEST_F(RecoveryTest, UndoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -211,7 +215,7 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
+TEST_F(RecoveryTest, CheckpointTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   EXPECT_FALSE(enable_logging);
@@ -225,6 +229,7 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   Transaction *txn = bustub_instance->transaction_manager_->Begin();
   auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
                                    bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
   bustub_instance->transaction_manager_->Commit(txn);
 
   Column col1{"a", TypeId::VARCHAR, 20};
@@ -233,84 +238,264 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   Schema schema{cols};
 
   Tuple tuple = ConstructTuple(&schema);
-  auto val_0 = tuple.GetValue(&schema, 0);
-  auto val_1 = tuple.GetValue(&schema, 1);
-
-  // set log time out very high so that flush doesn't happen before checkpoint is performed
-  log_timeout = std::chrono::seconds(15);
 
-  // insert a ton of tuples
+  // insert a ton of tuples, and write all of them to disk
   Transaction *txn1 = bustub_instance->transaction_manager_->Begin();
+  std::vector<RID> rids;
   for (int i = 0; i < 1000; i++) {
     RID rid;
     EXPECT_TRUE(test_table->InsertTuple(tuple, &rid, txn1));
+    rids.push_back(rid);
   }
   bustub_instance->transaction_manager_->Commit(txn1);
-
-  // Do checkpoint
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  lsn_t flushed_lsn = bustub_instance->log_manager_->GetNextLSN();
+
+  // Scenario: a checkpoint in the middle of running transactions neither blocks them nor writes any page back.
+  Transaction *winner = bustub_instance->transaction_manager_->Begin();
+  Transaction *loser = bustub_instance->transaction_manager_->Begin();
+  RID winner_rid;
+  RID loser_rid;
+  EXPECT_TRUE(test_table->InsertTuple(tuple, &winner_rid, winner));
+  EXPECT_TRUE(test_table->InsertTuple(tuple, &loser_rid, loser));
+  int writes = bustub_instance->disk_manager_->GetNumWrites();
   bustub_instance->checkpoint_manager_->BeginCheckpoint();
   bustub_instance->checkpoint_manager_->EndCheckpoint();
-
-  Page *pages = bustub_instance->buffer_pool_manager_->GetPages();
-  size_t pool_size = bustub_instance->buffer_pool_manager_->GetPoolSize();
-
-  // make sure that all pages in the buffer pool are marked as non-dirty
-  bool all_pages_clean = true;
-  for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
-    page_id_t page_id = page->GetPageId();
-
-    if (page_id != INVALID_PAGE_ID && page->IsDirty()) {
-      all_pages_clean = false;
-      break;
-    }
-  }
-  EXPECT_TRUE(all_pages_clean);
-
-  // compare each page in the buffer pool to that page's
-  // data on disk. ensure they match after the checkpoint
-  bool all_pages_match = true;
-  auto *disk_data = new char[PAGE_SIZE];
-  for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
-    page_id_t page_id = page->GetPageId();
-
-    if (page_id != INVALID_PAGE_ID) {
-      bustub_instance->disk_manager_->ReadPage(page_id, disk_data);
-      if (std::memcmp(disk_data, page->GetData(), PAGE_SIZE) != 0) {
-        all_pages_match = false;
-        break;
-      }
-    }
+  EXPECT_EQ(writes, bustub_instance->disk_manager_->GetNumWrites());
+  EXPECT_EQ(bustub_instance->log_manager_->GetNextLSN() - 1, bustub_instance->log_manager_->GetPersistentLSN());
+
+  // Scenario: only the pages changed since the flush are in the dirty page table, the active transactions in the
+  // active transaction table.
+  auto dirty_page_table = bustub_instance->buffer_pool_manager_->GetDirtyPageTable();
+  EXPECT_EQ(1, dirty_page_table.count(winner_rid.GetPageId()));
+  EXPECT_EQ(0, dirty_page_table.count(first_page_id));
+  for (const auto &[page_id, rec_lsn] : dirty_page_table) {
+    EXPECT_GE(rec_lsn, flushed_lsn);
   }
+  auto active_txn_table = bustub_instance->transaction_manager_->GetActiveTransactionTable();
+  EXPECT_EQ(2, active_txn_table.size());
+  EXPECT_EQ(loser->GetPrevLSN(), active_txn_table[loser->GetTransactionId()]);
+
+  RID after_rid;
+  EXPECT_TRUE(test_table->InsertTuple(tuple, &after_rid, winner));
+  bustub_instance->transaction_manager_->Commit(winner);
 
-  EXPECT_TRUE(all_pages_match);
-  delete[] disk_data;
+  delete txn;
+  delete txn1;
+  delete winner;
+  delete loser;
+  delete test_table;
 
-  // Verify all committed transactions flushed to disk
-  lsn_t persistent_lsn = bustub_instance->log_manager_->GetPersistentLSN();
-  lsn_t next_lsn = bustub_instance->log_manager_->GetNextLSN();
-  EXPECT_EQ(persistent_lsn, (next_lsn - 1));
+  LOG_INFO("System crash before the loser commits, no page is written back");
+  delete bustub_instance;
 
-  // verify log was flushed and each page's LSN <= persistent lsn
-  bool all_pages_lte = true;
-  for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
-    page_id_t page_id = page->GetPageId();
+  LOG_INFO("System restarted..");
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
 
-    if (page_id != INVALID_PAGE_ID && page->GetLSN() > persistent_lsn) {
-      all_pages_lte = false;
-      break;
-    }
-  }
+  // Scenario: redo starts at the lowest recLSN of the checkpoint, only the three inserts after the flush are redone.
+  log_recovery->Redo();
+  EXPECT_GE(log_recovery->GetRedoLSN(), flushed_lsn);
+  EXPECT_EQ(3, log_recovery->GetNumRedone());
+  log_recovery->Undo();
 
-  EXPECT_TRUE(all_pages_lte);
+  // Scenario: recovery keeps what was on disk and what the winner did on both sides of the checkpoint, not the loser.
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple old_tuple;
+  EXPECT_TRUE(test_table->GetTuple(rids.front(), &old_tuple, txn));
+  EXPECT_TRUE(test_table->GetTuple(rids.back(), &old_tuple, txn));
+  EXPECT_TRUE(test_table->GetTuple(winner_rid, &old_tuple, txn));
+  EXPECT_TRUE(test_table->GetTuple(after_rid, &old_tuple, txn));
+  EXPECT_FALSE(test_table->GetTuple(loser_rid, &old_tuple, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
 
   delete txn;
-  delete txn1;
   delete test_table;
+  delete log_recovery;
 
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, LargeCheckpointTest) {
+  // More dirty pages than the log buffer has room for in one record, every one of them changed before the checkpoint.
+  const int num_pages = LOG_BUFFER_SIZE / (sizeof(page_id_t) + sizeof(lsn_t)) + 100;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(num_pages, disk_manager, log_manager);
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager);
+  CheckpointManager checkpoint_manager(&txn_manager, log_manager, bpm);
+  log_manager->RunFlushThread();
+
+  Transaction *txn = txn_manager.Begin();
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id, page_id);
+    txn->SetPrevLSN(log_manager->AppendLogRecord(&log_record));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    prev_page_id = page_id;
+  }
+  txn_manager.Commit(txn);
+  delete txn;
+  ASSERT_EQ(static_cast<size_t>(num_pages), bpm->GetDirtyPageTable().size());
+
+  // Scenario: the checkpoint splits its dirty page table over several records instead of one too large for the log.
+  lsn_t begin_lsn = log_manager->GetNextLSN();
+  checkpoint_manager.BeginCheckpoint();
+  checkpoint_manager.EndCheckpoint();
+  EXPECT_GT(log_manager->GetNextLSN() - begin_lsn, 2);
+  EXPECT_EQ(log_manager->GetNextLSN() - 1, log_manager->GetPersistentLSN());
+
+  LOG_INFO("System crash, no page is written back");
+  log_manager->StopFlushThread();
+  delete bpm;
+  delete log_manager;
+
+  // Scenario: analysis merges the parts into one dirty page table, so that every page is redone.
+  bpm = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager);
+  auto *log_recovery = new LogRecovery(disk_manager, bpm);
+  log_recovery->Redo();
+  EXPECT_LT(log_recovery->GetRedoLSN(), begin_lsn);
+  EXPECT_EQ(static_cast<size_t>(num_pages), log_recovery->GetNumRedone());
+
+  delete log_recovery;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ParallelRedoTest) {
+  // One transaction creates a chain of pages and then updates a tuple on each of them round after round, so that the
+  // records of a page are spread over the whole log and the records next to each other belong to different workers.
+  const int num_pages = 24;
+  const int num_rounds = 20;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t prev_lsn = log_manager->AppendLogRecord(&begin_record);
+  std::vector<lsn_t> last_lsns(num_pages + 1);
+  for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+    LogRecord log_record(0, prev_lsn, LogRecordType::NEWPAGE, page_id == 1 ? INVALID_PAGE_ID : page_id - 1, page_id);
+    prev_lsn = log_manager->AppendLogRecord(&log_record);
+  }
+  for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+    LogRecord log_record(0, prev_lsn, LogRecordType::INSERT, RID(page_id, 0), MakeTuple(10, 'a'));
+    prev_lsn = log_manager->AppendLogRecord(&log_record);
+  }
+  for (int round = 1; round <= num_rounds; round++) {
+    for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+      Tuple old_tuple = MakeTuple(10 + round - 1, 'a' + round - 1);
+      Tuple new_tuple = MakeTuple(10 + round, 'a' + round);
+      LogRecord log_record(0, prev_lsn, LogRecordType::UPDATE, RID(page_id, 0), old_tuple, new_tuple);
+      prev_lsn = log_manager->AppendLogRecord(&log_record);
+      last_lsns[page_id] = prev_lsn;
+    }
+  }
+  LogRecord commit_record(0, prev_lsn, LogRecordType::COMMIT);
+  log_manager->FlushUntil(log_manager->AppendLogRecord(&commit_record));
+  delete log_manager;
+
+  // Scenario: the workers apply the records of each page in lsn order. A record applied after a later one of its page
+  // would be skipped as already on the page, so every record has to be counted as redone, and the page ends up at the
+  // lsn and the contents of its last update. The pool is smaller than the pages, so pages are evicted during redo.
+  auto *bpm = new BufferPoolManagerInstance(num_pages / 2, disk_manager);
+  auto *log_recovery = new LogRecovery(disk_manager, bpm, REDO_THREADS);
+  log_recovery->Redo();
+  EXPECT_EQ(static_cast<size_t>(num_pages * (num_rounds + 2)), log_recovery->GetNumRedone());
+  Tuple expected = MakeTuple(10 + num_rounds, 'a' + num_rounds);
+  for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    ASSERT_TRUE(static_cast<bool>(guard));
+    auto *page = guard.As<TablePage>();
+    EXPECT_EQ(last_lsns[page_id], page->GetLSN());
+    EXPECT_EQ(page_id == num_pages ? INVALID_PAGE_ID : page_id + 1, page->GetNextPageId());
+    Tuple result;
+    ASSERT_TRUE(page->GetTuple(RID(page_id, 0), &result, nullptr, nullptr));
+    ASSERT_EQ(expected.GetLength(), result.GetLength());
+    EXPECT_EQ(0, memcmp(expected.GetData(), result.GetData(), expected.GetLength()));
+  }
+
+  delete log_recovery;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, DISABLED_ParallelRedoBenchmarkTest) {
+  // A bulk load into many pages that were on disk when it began, none of its inserts made it there before the crash.
+  // Raise num_pages to recover from a log of several GB, at 1000 pages it is about 4 MB.
+  const int num_pages = 1000;
+  const int tuples_per_page = 30;
+  const int32_t tuple_length = 100;
+  Tuple tuple = MakeTuple(tuple_length, 'x');
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t prev_lsn = log_manager->AppendLogRecord(&begin_record);
+  for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+    LogRecord log_record(0, prev_lsn, LogRecordType::NEWPAGE, page_id == 1 ? INVALID_PAGE_ID : page_id - 1, page_id);
+    prev_lsn = log_manager->AppendLogRecord(&log_record);
+  }
+  for (int slot = 0; slot < tuples_per_page; slot++) {
+    for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+      LogRecord log_record(0, prev_lsn, LogRecordType::INSERT, RID(page_id, slot), tuple);
+      prev_lsn = log_manager->AppendLogRecord(&log_record);
+    }
+  }
+  LogRecord commit_record(0, prev_lsn, LogRecordType::COMMIT);
+  log_manager->FlushUntil(log_manager->AppendLogRecord(&commit_record));
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: redo with one worker and with several rebuilds the same pages, and logs how long each took. The pages
+  // are read with direct I/O where the file system allows it, so that misses wait for the disk as after a restart.
+  for (size_t num_threads : {static_cast<size_t>(1), static_cast<size_t>(REDO_THREADS)}) {
+    remove("test.db");
+    disk_manager = new DiskManager("test.db", true);
+    auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+    for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+      WritePageGuard guard = bpm->FetchPageWrite(page_id);
+      ASSERT_TRUE(static_cast<bool>(guard));
+      auto *page = guard.AsMut<TablePage>();
+      page->Init(page_id, PAGE_SIZE, page_id == 1 ? INVALID_PAGE_ID : page_id - 1, nullptr, nullptr);
+      page->SetNextPageId(page_id == num_pages ? INVALID_PAGE_ID : page_id + 1);
+      page->SetLSN(page_id);
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+    bpm = new BufferPoolManagerInstance(64, disk_manager);
+    auto *log_recovery = new LogRecovery(disk_manager, bpm, num_threads);
+
+    auto start = std::chrono::steady_clock::now();
+    log_recovery->Redo();
+    [[maybe_unused]] auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("redo with %zu workers: %zu records/s, %d page reads", num_threads,
+             static_cast<size_t>(num_pages * tuples_per_page / elapsed), disk_manager->GetNumReads());
+    EXPECT_EQ(static_cast<size_t>(num_pages * tuples_per_page), log_recovery->GetNumRedone());
+
+    for (page_id_t page_id = 1; page_id <= num_pages; page_id++) {
+      ReadPageGuard guard = bpm->FetchPageRead(page_id);
+      ASSERT_TRUE(static_cast<bool>(guard));
+      auto *page = guard.As<TablePage>();
+      Tuple result;
+      EXPECT_TRUE(page->GetTuple(RID(page_id, tuples_per_page - 1), &result, nullptr, nullptr));
+      EXPECT_EQ(0, memcmp(result.GetData(), tuple.GetData(), tuple_length));
+      EXPECT_EQ(page_id == num_pages ? INVALID_PAGE_ID : page_id + 1, page->GetNextPageId());
+    }
+
+    delete log_recovery;
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+}
 }  // namespace bustub
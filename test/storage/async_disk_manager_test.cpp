@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager_test.cpp
+//
+// Identification: test/storage/async_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class AsyncDiskManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+  };
+};
+
+// NOLINTNEXTLINE
+TEST_F(AsyncDiskManagerTest, ReadWritePageTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  AsyncDiskManager dm("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Scenario: a page beyond the end of the file reads as zeros.
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(5, buf);
+  std::memset(data, 0, sizeof(data));
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Scenario: async requests complete through their futures.
+  std::strncpy(data, "Another test string.", sizeof(data));
+  std::future<void> written = dm.WritePageAsync(3, data);
+  written.wait();
+  std::future<void> read = dm.ReadPageAsync(3, buf);
+  read.wait();
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Scenario: a page beyond 4 GB is written and read at its own offset.
+  const page_id_t far_page_id = (1 << 20) + 3;
+  std::strncpy(data, "A far away test string.", sizeof(data));
+  dm.WritePage(far_page_id, data);
+  std::memset(buf, 0, sizeof(buf));
+  dm.ReadPage(far_page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  dm.ReadPage(3, buf);
+  EXPECT_EQ(std::string("Another test string."), std::string(buf));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(AsyncDiskManagerTest, BatchTest) {
+  const size_t num_pages = 100;
+  // A queue depth far below the batch size, so that submission has to wait for completions.
+  AsyncDiskManager dm("test.db", 8);
+
+  // Scenario: a batch larger than the queue depth is written and read back completely.
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<page_id_t> page_ids;
+  std::vector<const char *> data;
+  for (size_t i = 0; i < num_pages; i++) {
+    std::memset(pages[i].data(), static_cast<int>(i), PAGE_SIZE);
+    page_ids.push_back(static_cast<page_id_t>(num_pages - 1 - i));
+    data.push_back(pages[i].data());
+  }
+  dm.WritePages(page_ids, data);
+  EXPECT_EQ(static_cast<int>(num_pages), dm.GetNumWrites());
+
+  std::vector<std::vector<char>> results(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<char *> buffers;
+  for (auto &result : results) {
+    buffers.push_back(result.data());
+  }
+  dm.ReadPages(page_ids, buffers);
+  EXPECT_EQ(static_cast<int>(num_pages), dm.GetNumReads());
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(pages[i], results[i]);
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(AsyncDiskManagerTest, RegisteredBuffersTest) {
+  const size_t num_pages = 4;
+  AsyncDiskManager dm("test.db");
+  std::vector<char> region(num_pages * PAGE_SIZE);
+  std::vector<char> other(PAGE_SIZE, 'o');
+
+  // Scenario: pages inside a registered range and outside of it are read and written alike.
+  bool registered = dm.RegisterBuffers(region.data(), region.size());
+  EXPECT_EQ(dm.IsUringEnabled(), registered);
+  for (size_t i = 0; i < num_pages; i++) {
+    std::memset(region.data() + i * PAGE_SIZE, 'a' + static_cast<int>(i), PAGE_SIZE);
+    dm.WritePage(static_cast<page_id_t>(i), region.data() + i * PAGE_SIZE);
+  }
+  dm.WritePage(num_pages, other.data());
+  std::memset(region.data(), 0, region.size());
+  dm.ReadPages({3, 2, 1, 0}, {region.data(), region.data() + PAGE_SIZE, region.data() + 2 * PAGE_SIZE,
+                              region.data() + 3 * PAGE_SIZE});
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ('a' + static_cast<int>(num_pages - 1 - i), region[i * PAGE_SIZE + PAGE_SIZE - 1]);
+  }
+
+  // Scenario: after unregistering, the memory is still read into as usual.
+  dm.UnregisterBuffers(region.data());
+  dm.ReadPage(num_pages, region.data());
+  EXPECT_EQ('o', region[PAGE_SIZE - 1]);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(AsyncDiskManagerTest, DirectIoTest) {
+  const size_t num_pages = 16;
+  AsyncDiskManager dm("test.db", 4, true);
+
+  // Scenario: unaligned buffers in a batch are written and read back through aligned copies.
+  std::vector<char> region(num_pages * PAGE_SIZE + 1);
+  std::vector<page_id_t> page_ids;
+  std::vector<const char *> data;
+  std::vector<char *> buffers;
+  for (size_t i = 0; i < num_pages; i++) {
+    char *page = region.data() + 1 + i * PAGE_SIZE;
+    std::memset(page, 'a' + static_cast<int>(i), PAGE_SIZE);
+    page_ids.push_back(static_cast<page_id_t>(i));
+    data.push_back(page);
+    buffers.push_back(page);
+  }
+  dm.WritePages(page_ids, data);
+  std::memset(region.data(), 0, region.size());
+  dm.ReadPages(page_ids, buffers);
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ('a' + static_cast<int>(i), buffers[i][0]);
+    EXPECT_EQ('a' + static_cast<int>(i), buffers[i][PAGE_SIZE - 1]);
+  }
+
+  // Scenario: a pool on a direct I/O disk manager reads its evicted pages back.
+  auto *bpm = new BufferPoolManagerInstance(4, &dm);
+  std::vector<page_id_t> pool_page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    pool_page_ids.push_back(page_id);
+  }
+  for (page_id_t page_id : pool_page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  delete bpm;
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(AsyncDiskManagerTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_pages = 4 * buffer_pool_size;
+  auto *disk_manager = new AsyncDiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a pool on an async disk manager writes back its victims and batches and reads them in again.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  std::vector<page_id_t> batch(page_ids.begin(), page_ids.begin() + buffer_pool_size);
+  std::vector<Page *> pages = bpm->FetchPages(batch);
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(std::to_string(batch[i]), std::string(pages[i]->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(batch[i], false));
+  }
+
+  // Scenario: a prefetched range is read as one batch, later fetches of it do not go to disk.
+  int reads_before = disk_manager->GetNumReads();
+  page_id_t first_page_id = page_ids[num_pages - buffer_pool_size];
+  bpm->PrefetchRange(first_page_id, buffer_pool_size);
+  for (int i = 0; i < 5000 && disk_manager->GetNumReads() < reads_before + static_cast<int>(buffer_pool_size); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (size_t i = num_pages - buffer_pool_size; i < num_pages; i++) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(reads_before + static_cast<int>(buffer_pool_size), disk_manager->GetNumReads());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -8,7 +8,7 @@
 #include <thread>                   // NOLINT
 #include "b_plus_tree_test_util.h"  // NOLINT
 
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
 
@@ -98,7 +98,7 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ InsertTest1) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
   // create and fetch header_page
@@ -139,8 +139,8 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ InsertTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -150,7 +150,7 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ InsertTest2) {
   Schema *key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema);
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
   // create and fetch header_page
@@ -191,8 +191,8 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ InsertTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -203,7 +203,7 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ DeleteTest1) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
   GenericKey<8> index_key;
@@ -234,8 +234,8 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ DeleteTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -246,7 +246,7 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ DeleteTest2) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
   GenericKey<8> index_key;
@@ -278,8 +278,8 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ DeleteTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -290,7 +290,7 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ MixTest) {
   GenericComparator<8> comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
-  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
   // create b+ tree
   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
   GenericKey<8> index_key;
@@ -324,8 +324,79 @@ TEST(BPlusTreeConcurrentTest, /*DISABLED_*/ MixTest) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete key_schema;
+  delete bpm;
   delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticLookupTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree, small nodes so the writers keep splitting and merging inner pages
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // the even keys stay in the tree the whole time, the odd ones come and go
+  const int64_t scale_factor = 200;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> volatile_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    (key % 2 == 0 ? stable_keys : volatile_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  // Scenario: lookups that descend without latching the inner pages still find every stable key, while writers
+  // restructure the tree underneath them.
+  auto lookup_helper = [&tree, &stable_keys](uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    Transaction transaction(0);
+    for (int round = 0; round < 20; round++) {
+      for (auto key : stable_keys) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.GetValue(index_key, &rids, thread_itr % 2 == 0 ? &transaction : nullptr));
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].GetSlotNum(), key & 0xFFFFFFFF);
+      }
+    }
+  };
+  auto write_helper = [&tree, &volatile_keys](uint64_t thread_itr) {
+    for (int round = 0; round < 10; round++) {
+      InsertHelperSplit(&tree, volatile_keys, 2, thread_itr);
+      DeleteHelperSplit(&tree, volatile_keys, 2, thread_itr);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (uint64_t thread_itr = 0; thread_itr < 4; thread_itr++) {
+    threads.emplace_back(lookup_helper, thread_itr);
+  }
+  for (uint64_t thread_itr = 0; thread_itr < 2; thread_itr++) {
+    threads.emplace_back(write_helper, thread_itr);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  int64_t size = 0;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    EXPECT_EQ((*iterator).first.ToString() % 2, 0);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, stable_keys.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
 #include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -55,6 +58,238 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 32;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: threads writing and reading back their own pages at the same time never see each other's data.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + tid;
+          std::memset(data, page_id + round, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4 * num_threads * pages_per_thread, dm.GetNumWrites());
+  EXPECT_EQ(4 * num_threads * pages_per_thread, dm.GetNumReads());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  // Direct I/O is only used where the file system supports it, the pages read back the same either way.
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, true);
+  alignas(PAGE_SIZE) char aligned[PAGE_SIZE];
+  std::vector<char> buffer(PAGE_SIZE + 1);
+  char *unaligned = buffer.data() + 1;
+
+  // Scenario: an aligned buffer is written and read as it is.
+  std::memset(aligned, 'a', sizeof(aligned));
+  dm.WritePage(0, aligned);
+  std::memset(aligned, 0, sizeof(aligned));
+  dm.ReadPage(0, aligned);
+  EXPECT_EQ('a', aligned[0]);
+  EXPECT_EQ('a', aligned[PAGE_SIZE - 1]);
+
+  // Scenario: an unaligned buffer is written and read through an aligned copy.
+  std::memset(unaligned, 'u', PAGE_SIZE);
+  dm.WritePage(1, unaligned);
+  std::memset(unaligned, 0, PAGE_SIZE);
+  dm.ReadPage(1, unaligned);
+  EXPECT_EQ('u', unaligned[0]);
+  EXPECT_EQ('u', unaligned[PAGE_SIZE - 1]);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocatePageTest) {
+  const page_id_t num_pages = DISK_EXTENT_SIZE + 10;
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+
+  // Scenario: pages are allocated in order, across the end of the first extent.
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(i, dm->AllocatePage());
+    std::memset(data, i % 128, sizeof(data));
+    dm->WritePage(i, data);
+  }
+  EXPECT_EQ(num_pages, dm->GetNextPageId());
+
+  // Scenario: deallocated pages are handed out again, lowest page id first, before the file grows.
+  dm->DeallocatePage(7);
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(3);
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(num_pages, dm->AllocatePage());
+  EXPECT_EQ(num_pages + 1, dm->GetNextPageId());
+
+  // Scenario: a stride only hands out page ids with the given offset, whatever else is free.
+  dm->DeallocatePage(4);
+  dm->DeallocatePage(5);
+  EXPECT_EQ(5, dm->AllocatePage(2, 1));
+  EXPECT_EQ(num_pages + 1, dm->AllocatePage(2, 1));
+  EXPECT_EQ(4, dm->AllocatePage(2, 0));
+
+  // Scenario: deallocating the highest page lowers the next page id.
+  EXPECT_EQ(num_pages + 2, dm->GetNextPageId());
+  dm->DeallocatePage(num_pages + 1);
+  EXPECT_EQ(num_pages + 1, dm->GetNextPageId());
+  dm->DeallocatePage(12);
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: after a restart the allocation state comes back from the file, and so do the pages.
+  dm = new DiskManager(db_file);
+  EXPECT_EQ(num_pages + 1, dm->GetNextPageId());
+  EXPECT_EQ(12, dm->AllocatePage());
+  EXPECT_EQ(num_pages + 1, dm->AllocatePage());
+  char buf[PAGE_SIZE];
+  for (page_id_t i : {0, 11, DISK_EXTENT_SIZE - 1, DISK_EXTENT_SIZE, num_pages - 1}) {
+    std::memset(data, i % 128, sizeof(data));
+    dm->ReadPage(i, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  }
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LazyExtentHeaderTest) {
+  std::string db_file("test.db");
+  DiskManager dm(db_file);
+  auto file_size = [&db_file] {
+    struct stat stat_buf;
+    return stat(db_file.c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
+  };
+
+  // Scenario: allocating pages does not touch the file, so it can be done under the latch of a buffer pool.
+  EXPECT_EQ(0, dm.AllocatePage());
+  EXPECT_EQ(1, dm.AllocatePage());
+  EXPECT_EQ(2, dm.AllocatePage());
+  EXPECT_EQ(0, file_size());
+
+  // Scenario: writing a page writes the extent header first, another disk manager on the file finds the allocations.
+  char data[PAGE_SIZE];
+  std::memset(data, 1, sizeof(data));
+  dm.WritePage(1, data);
+  EXPECT_EQ(3 * PAGE_SIZE, file_size());
+  {
+    DiskManager other(db_file);
+    EXPECT_EQ(3, other.GetNextPageId());
+  }
+
+  // Scenario: a deallocation reaches the file on the next sync.
+  dm.DeallocatePage(2);
+  {
+    DiskManager other(db_file);
+    EXPECT_EQ(3, other.GetNextPageId());
+  }
+  dm.Sync();
+  {
+    DiskManager other(db_file);
+    EXPECT_EQ(2, other.GetNextPageId());
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  // Pages around the 2 GB and beyond the 4 GB offsets, the file stays sparse in between.
+  const auto below_2gb =
+      static_cast<page_id_t>((int64_t{1} << 31) / (PAGE_SIZE + PAGE_SIZE / DISK_EXTENT_SIZE) - DISK_EXTENT_SIZE);
+  const page_id_t above_2gb = below_2gb + 2 * DISK_EXTENT_SIZE;
+  const page_id_t above_4gb = 2 * above_2gb;
+  char buf[PAGE_SIZE];
+  char data[PAGE_SIZE];
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+
+  // Scenario: pages on both sides of 2 GB and beyond 4 GB are written and read back at their own offsets.
+  for (page_id_t page_id : {below_2gb, above_2gb, above_4gb}) {
+    std::memset(data, page_id % 128, sizeof(data));
+    dm->WritePage(page_id, data);
+  }
+  for (page_id_t page_id : {below_2gb, above_2gb, above_4gb}) {
+    std::memset(data, page_id % 128, sizeof(data));
+    dm->ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  }
+
+  // Scenario: a page in the hole between them is inside the file and reads as zeros.
+  std::memset(buf, 'x', sizeof(buf));
+  std::memset(data, 0, sizeof(data));
+  dm->ReadPage(above_2gb + 1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(4, dm->GetNumReads());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: after a restart the pages are still there, and none of them is allocated again.
+  dm = new DiskManager(db_file);
+  EXPECT_EQ(above_4gb + 1, dm->GetNextPageId());
+  std::memset(data, above_4gb % 128, sizeof(data));
+  dm->ReadPage(above_4gb, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: a batch out of order, with runs across the end of an extent, lands every page at its own offset.
+  std::vector<page_id_t> page_ids = {DISK_EXTENT_SIZE + 1, 2, DISK_EXTENT_SIZE - 1, 0, DISK_EXTENT_SIZE, 1, 5};
+  std::vector<std::vector<char>> pages;
+  std::vector<const char *> data;
+  for (page_id_t page_id : page_ids) {
+    pages.emplace_back(PAGE_SIZE, static_cast<char>('a' + page_id % 26));
+  }
+  for (auto &page : pages) {
+    data.push_back(page.data());
+  }
+  dm.WritePages(page_ids, data);
+  EXPECT_EQ(static_cast<int>(page_ids.size()), dm.GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    dm.ReadPage(page_ids[i], buf);
+    EXPECT_EQ(std::memcmp(buf, pages[i].data(), sizeof(buf)), 0);
+  }
+
+  // Scenario: a page that is in the batch twice ends up with the later of its two versions.
+  std::vector<char> first(PAGE_SIZE, 'x');
+  std::vector<char> second(PAGE_SIZE, 'y');
+  dm.WritePages({3, 4, 3}, {first.data(), first.data(), second.data()});
+  dm.ReadPage(3, buf);
+  EXPECT_EQ('y', buf[0]);
+  dm.ReadPage(4, buf);
+  EXPECT_EQ('x', buf[0]);
+
+  dm.Sync();
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
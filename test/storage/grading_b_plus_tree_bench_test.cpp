@@ -10,7 +10,7 @@
 // #include <thread>  // NOLINT
 
 // #include "b_plus_tree_test_util.h"  // NOLINT
-// #include "buffer/buffer_pool_manager.h"
+// #include "buffer/buffer_pool_manager_instance.h"
 // #include "common/logger.h"
 // #include "gtest/gtest.h"
 // #include "storage/index/b_plus_tree.h"
@@ -177,8 +177,8 @@
 //     Schema *key_schema = ParseCreateStatement("a bigint");
 //     GenericComparator<8> comparator(key_schema);
 //     DiskManager *disk_manager = new DiskManager("test.db");
-//     // BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
-//     BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+//     // BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+//     BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
 //     // create b+ tree
 //     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //     // create and fetch header_page
@@ -6,7 +6,7 @@
 // #include <random>
 
 // #include "b_plus_tree_test_util.h"  // NOLINT
-// #include "buffer/buffer_pool_manager.h"
+// #include "buffer/buffer_pool_manager_instance.h"
 // #include "gtest/gtest.h"
 // #include "storage/index/b_plus_tree.h"
 
@@ -24,7 +24,7 @@
 //   GenericComparator<8> comparator(key_schema);
 
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 2, 3);
 //   GenericKey<8> index_key;
@@ -88,7 +88,7 @@
 //   GenericComparator<8> comparator(key_schema);
 
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -141,7 +141,7 @@
 //   GenericComparator<8> comparator(key_schema);
 
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -194,7 +194,7 @@
 //   GenericComparator<8> comparator(key_schema);
 
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(30, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -9,7 +9,7 @@
 #include <thread>  // NOLINT
 
 #include "b_plus_tree_test_util.h"  // NOLINT
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
 
@@ -131,7 +131,7 @@ void InsertTest1Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
     // create and fetch header_page
@@ -172,8 +172,8 @@ void InsertTest1Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -186,7 +186,7 @@ void InsertTest2Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
     // create and fetch header_page
@@ -227,8 +227,8 @@ void InsertTest2Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -241,7 +241,7 @@ void DeleteTest1Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
     // create and fetch header_page
@@ -271,8 +271,8 @@ void DeleteTest1Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -285,7 +285,7 @@ void DeleteTest2Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
     // create and fetch header_page
@@ -316,8 +316,8 @@ void DeleteTest2Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -330,7 +330,7 @@ void MixTest1Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 
@@ -378,8 +378,8 @@ void MixTest1Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -392,7 +392,7 @@ void MixTest2Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
     // create and fetch header_page
@@ -447,8 +447,8 @@ void MixTest2Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -461,7 +461,7 @@ void MixTest3Call() {
     GenericComparator<8> comparator(key_schema);
 
     DiskManager *disk_manager = new DiskManager("test.db");
-    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
     // create b+ tree
     BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 
@@ -508,8 +508,8 @@ void MixTest3Call() {
 
     bpm->UnpinPage(HEADER_PAGE_ID, true);
     delete key_schema;
-    delete disk_manager;
     delete bpm;
+    delete disk_manager;
     remove("test.db");
     remove("test.log");
   }
@@ -9,7 +9,7 @@
 // #include <thread>  // NOLINT
 
 // #include "b_plus_tree_test_util.h"  // NOLINT
-// #include "buffer/buffer_pool_manager.h"
+// #include "buffer/buffer_pool_manager_instance.h"
 // #include "gtest/gtest.h"
 // #include "storage/index/b_plus_tree.h"
 
@@ -22,7 +22,7 @@
 //   GenericComparator<8> comparator(key_schema);
 
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -68,7 +68,7 @@
 //   Schema *key_schema = ParseCreateStatement("a bigint");
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -111,7 +111,7 @@
 //   Schema *key_schema = ParseCreateStatement("a bigint");
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -165,7 +165,7 @@
 //   Schema *key_schema = ParseCreateStatement("a bigint");
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -230,7 +230,7 @@
 //   Schema *key_schema = ParseCreateStatement(createStmt);
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -304,7 +304,7 @@
 //   Schema *key_schema = ParseCreateStatement("a bigint");
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(5, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
@@ -378,7 +378,7 @@
 //   Schema *key_schema = ParseCreateStatement("a bigint");
 //   GenericComparator<8> comparator(key_schema);
 //   DiskManager *disk_manager = new DiskManager("test.db");
-//   BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+//   BufferPoolManager *bpm = new BufferPoolManagerInstance(20, disk_manager);
 //   // create b+ tree
 //   BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
 //   GenericKey<8> index_key;
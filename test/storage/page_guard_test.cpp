@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+
+  // Scenario: a guard holds its own pin and gives it back when it goes out of scope.
+  {
+    BasicPageGuard guard = bpm->FetchPageBasic(page_id);
+    ASSERT_TRUE(static_cast<bool>(guard));
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(2, page->GetPinCount());
+  }
+  EXPECT_EQ(1, page->GetPinCount());
+
+  // Scenario: moving a guard hands the pin over instead of taking another one.
+  {
+    BasicPageGuard guard = bpm->FetchPageBasic(page_id);
+    BasicPageGuard moved_guard(std::move(guard));
+    EXPECT_FALSE(static_cast<bool>(guard));  // NOLINT
+    EXPECT_EQ(2, page->GetPinCount());
+    BasicPageGuard assigned_guard;
+    assigned_guard = std::move(moved_guard);
+    EXPECT_EQ(2, page->GetPinCount());
+    assigned_guard.Drop();
+    EXPECT_EQ(1, page->GetPinCount());
+    assigned_guard.Drop();
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(1, page->GetPinCount());
+
+  // Scenario: only writing through the guard marks the page dirty. A new page starts out dirty, flushing it while it
+  // is unpinned makes it clean.
+  EXPECT_TRUE(page->IsDirty());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  bpm->FlushAllPages();
+  ASSERT_EQ(page, bpm->FetchPage(page_id));
+  EXPECT_FALSE(page->IsDirty());
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(0, guard.GetData()[0]);
+  }
+  EXPECT_FALSE(page->IsDirty());
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_TRUE(page->IsDirty());
+  EXPECT_EQ(1, page->GetPinCount());
+
+  // Scenario: guards release their latches, a read latch is followed by a write latch and the other way around without
+  // blocking. Assigning over a guard releases the page it held first.
+  {
+    ReadPageGuard read_guard = bpm->FetchPageRead(page_id);
+    ReadPageGuard other_read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ("Hello", std::string(read_guard.GetData()));
+    EXPECT_EQ(3, page->GetPinCount());
+    read_guard = std::move(other_read_guard);
+    EXPECT_EQ(2, page->GetPinCount());
+  }
+  {
+    WritePageGuard write_guard = bpm->FetchPageBasic(page_id).UpgradeWrite();
+    EXPECT_EQ(2, page->GetPinCount());
+  }
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: when the buffer pool is full, the guard is empty and releases nothing.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t pinned_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&pinned_page_id));
+  }
+  {
+    page_id_t new_page_id;
+    BasicPageGuard new_guard = bpm->NewPageGuarded(&new_page_id);
+    EXPECT_FALSE(static_cast<bool>(new_guard));
+    WritePageGuard write_guard = bpm->FetchPageWrite(page_id);
+    EXPECT_FALSE(static_cast<bool>(write_guard));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub